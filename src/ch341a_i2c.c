@@ -12,6 +12,7 @@
 #include <string.h>
 #include <assert.h>
 #include "ch341a_i2c.h"
+#include "ch341a_spi.h"
 
 /* Global debug flag from main.c */
 extern int debug_enabled;
@@ -118,7 +119,7 @@ int32_t ch341readEEPROM(uint8_t *buffer, uint32_t bytestoread, struct EEPROM *ee
 	uint8_t ch341inBuffer[IN_BUF_SZ]; // 0x100 bytes
 	int32_t ret = 0, readpktcount = 0;
 	struct libusb_transfer *xferBulkIn, *xferBulkOut;
-	struct timeval tv = {0, 100}; // our async polling interval
+	unsigned long seen = 0;
 
 	dprintf("ch341readEEPROM: reading %u bytes\n", bytestoread);
 
@@ -162,25 +163,18 @@ int32_t ch341readEEPROM(uint8_t *buffer, uint32_t bytestoread, struct EEPROM *ee
 
 	readbuf = buffer;
 
+	// The callbacks run on the USB event thread; sleep until one reports in
+	ch341a_usb_lock();
 	while (1)
 	{
-		printf("Read %d%% [%d] of [%d] bytes      ", 100 * byteoffset / bytestoread, byteoffset, bytestoread);
-		printf("\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b");
-		fflush(stdout);
-		ret = libusb_handle_events_timeout(NULL, &tv);
+		ch341a_usb_wait(&seen);
 
-			if (ret < 0 || (int32_t)getnextpkt == -1)
+		if ((int32_t)getnextpkt == -1)
 		{								       // indicates an error
-			fprintf(stderr, "ret from libusb_handle_timeout = %d\n", ret); // Use stderr
 			fprintf(stderr, "getnextpkt = %d\n", getnextpkt);	       // Use stderr
-			if (ret < 0)
-			{
-				fprintf(stderr, "USB read error : %s\n", strerror(-ret)); // Use stderr
-				if (debug_enabled)
-					fprintf(stderr, "[DEBUG] ch341readEEPROM: libusb_handle_events_timeout error %d\n", ret);
-			}
 			if (debug_enabled)
 				fprintf(stderr, "[DEBUG] ch341readEEPROM: read operation failed, aborting\n");
+			ch341a_usb_unlock();
 			libusb_free_transfer(xferBulkIn);
 			libusb_free_transfer(xferBulkOut);
 			return -1;
@@ -193,6 +187,10 @@ int32_t ch341readEEPROM(uint8_t *buffer, uint32_t bytestoread, struct EEPROM *ee
 			if (byteoffset == bytestoread)
 				break;
 
+			printf("Read %d%% [%d] of [%d] bytes      ", 100 * byteoffset / bytestoread, byteoffset, bytestoread);
+			printf("\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b");
+			fflush(stdout);
+
 			dprintf("\nRe-submitting transfer request to BULK IN endpoint\n");
 			libusb_submit_transfer(xferBulkIn); // re-submit request for next BULK IN packet of EEPROM data
 			if (syncackpkt)
@@ -213,6 +211,7 @@ int32_t ch341readEEPROM(uint8_t *buffer, uint32_t bytestoread, struct EEPROM *ee
 			}
 		}
 	}
+	ch341a_usb_unlock();
 	printf("Read 100%% [%d] of [%d] bytes      \n", byteoffset, bytestoread);
 
 	if (debug_enabled)
@@ -243,15 +242,21 @@ void cbBulkIn(struct libusb_transfer *transfer)
 		}
 		dprintf("\n");
 		// copy read data to our EEPROM buffer
+		ch341a_usb_lock();
 		memcpy(readbuf + byteoffset, transfer->buffer, transfer->actual_length);
 		getnextpkt = 1;
+		ch341a_usb_signal();
+		ch341a_usb_unlock();
 		break;
 	default:
 		fprintf(stderr, "\ncbBulkIn: error : %d\n", transfer->status); // Use stderr
 		if (debug_enabled)
 			fprintf(stderr, "[DEBUG] cbBulkIn: transfer failed with status %d (%s)\n",
 				transfer->status, libusb_error_name(transfer->status));
+		ch341a_usb_lock();
 		getnextpkt = -1;
+		ch341a_usb_signal();
+		ch341a_usb_unlock();
 	}
 	return;
 }
@@ -259,7 +264,10 @@ void cbBulkIn(struct libusb_transfer *transfer)
 // Callback function for async bulk out comms
 void cbBulkOut(struct libusb_transfer *transfer __attribute__((unused)))
 {
+	ch341a_usb_lock();
 	syncackpkt = 1;
+	ch341a_usb_signal();
+	ch341a_usb_unlock();
 	dprintf("cbBulkOut(): Sync/Ack received: status %d\n", transfer->status);
 	if (transfer->status != LIBUSB_TRANSFER_COMPLETED && debug_enabled)
 		fprintf(stderr, "[DEBUG] cbBulkOut: transfer completed with non-success status %d (%s)\n",
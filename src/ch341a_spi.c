@@ -15,7 +15,12 @@
  * - Optimized for low packet overhead (15%+ reduction target)
  */
 #include <string.h>
+#include <stdlib.h>
 #include <stdio.h>
+#include <time.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/stat.h>
 #include "ch341a_spi.h"
 #include <libusb-1.0/libusb.h>
 #include <stdbool.h>
@@ -96,6 +101,39 @@ static void trace_dump(const char *label, const unsigned char *buf, unsigned int
  */
 #define USB_IN_TRANSFERS 32
 
+/* OUT transfers that may be queued behind the main one in a single
+ * usb_transfer() call: the CS-high tail of a transaction, or the further
+ * commands of a write-combined batch plus its tail.
+ */
+#define USB_OUT_MORE 16
+
+/* Transfer settings that depend on the host, hub and programmer rather than on
+ * the CH341A itself. The defaults are the compile-time values above; a
+ * calibration run asked for with --calibrate (see ch341a_tune()) replaces them
+ * with measured ones, which are cached per programmer so later runs start
+ * tuned.
+ */
+struct ch341a_tuning
+{
+	unsigned int in_transfers; /* IN transfers kept in flight, <= USB_IN_TRANSFERS */
+	unsigned int xfer_bytes;   /* stream split size, <= CH341_MAX_XFER_BYTES */
+	unsigned int bytes_per_ms; /* payload rate assumed when sizing timeouts */
+};
+
+/* Payload rate the default timeouts assume. Calibration may only lower it, so
+ * a measurement taken on an idle host never shortens a timeout. */
+#define CH341_BYTES_PER_MS 8
+
+static struct ch341a_tuning tuning = { USB_IN_TRANSFERS, CH341_MAX_XFER_BYTES, CH341_BYTES_PER_MS };
+static bool tuning_forced = false;
+
+/* One additional OUT buffer for usb_transfer() */
+struct usb_out
+{
+	const uint8_t *buf;
+	unsigned int len;
+};
+
 struct dev_entry
 {
 	uint16_t vendor_id;
@@ -111,7 +149,19 @@ struct dev_entry
  */
 #ifndef __EMSCRIPTEN__
 static struct libusb_transfer *transfer_out = NULL;
+static struct libusb_transfer *transfer_more[USB_OUT_MORE] = {0};
 static struct libusb_transfer *transfer_ins[USB_IN_TRANSFERS] = {0};
+
+/* Packet buffers reused by every stream instead of per-call stack arrays.
+ * Sized for the largest stream ch341a_spi_send_split() lets through, plus a
+ * lead packet per command of a full transaction batch. Taken from usbfs
+ * mapped memory when libusb and the kernel support it, so the kernel can
+ * skip its bounce copy, and from the heap otherwise. */
+#define CH341_ARENA_PACKETS (USB_OUT_MORE + (CH341_MAX_XFER_BYTES + CH341_PACKET_LENGTH - 2) / (CH341_PACKET_LENGTH - 1))
+#define CH341_ARENA_WLEN (CH341_ARENA_PACKETS * CH341_PACKET_LENGTH)
+#define CH341_ARENA_RLEN CH341_MAX_XFER_BYTES
+static uint8_t *arena = NULL;
+static bool arena_devmem = false;
 #endif
 struct libusb_device_handle *handle = NULL;
 
@@ -130,6 +180,87 @@ const struct dev_entry devs_ch341a_spi[] = {
 };
 
 #ifndef __EMSCRIPTEN__
+/* libusb events are handled by a background thread started at init. Transfer
+ * callbacks run on that thread: they update their state under event_lock and
+ * broadcast event_cond, and waiters sleep on the condition instead of
+ * polling libusb themselves. If the thread cannot be started, waiters fall
+ * back to handling events on their own thread.
+ */
+static pthread_t event_thread;
+static bool event_thread_running = false;
+static int event_thread_stop = 0;
+static pthread_mutex_t event_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t event_cond = PTHREAD_COND_INITIALIZER;
+static unsigned long event_gen = 0;
+
+static void *event_thread_main(void *arg)
+{
+	(void)arg;
+	while (!event_thread_stop)
+		libusb_handle_events_timeout_completed(NULL, &(struct timeval){1, 0}, &event_thread_stop);
+	return NULL;
+}
+
+static void event_thread_start(void)
+{
+	event_thread_stop = 0;
+	if (pthread_create(&event_thread, NULL, event_thread_main, NULL) == 0)
+		event_thread_running = true;
+	else
+		fprintf(stderr, "Failed to start USB event thread, polling instead\n");
+}
+
+static void event_thread_join(void)
+{
+	if (!event_thread_running)
+		return;
+	event_thread_stop = 1;
+#if LIBUSB_API_VERSION >= 0x01000105
+	libusb_interrupt_event_handler(NULL);
+#endif
+	pthread_join(event_thread, NULL);
+	event_thread_running = false;
+}
+
+void ch341a_usb_lock(void)
+{
+	pthread_mutex_lock(&event_lock);
+}
+
+void ch341a_usb_unlock(void)
+{
+	pthread_mutex_unlock(&event_lock);
+}
+
+/* Wake waiters after changing transfer state; call with the lock held */
+void ch341a_usb_signal(void)
+{
+	event_gen++;
+	pthread_cond_broadcast(&event_cond);
+}
+
+/* With the lock held, sleep until a callback signals something newer than
+ * *seen, or for at most a second. */
+void ch341a_usb_wait(unsigned long *seen)
+{
+	if (!event_thread_running)
+	{
+		pthread_mutex_unlock(&event_lock);
+		libusb_handle_events_timeout(NULL, &(struct timeval){1, 0});
+		pthread_mutex_lock(&event_lock);
+	}
+	else if (event_gen == *seen)
+	{
+		struct timespec ts;
+		clock_gettime(CLOCK_REALTIME, &ts);
+		ts.tv_sec += 1;
+		while (event_gen == *seen)
+			if (pthread_cond_timedwait(&event_cond, &event_lock, &ts) == ETIMEDOUT)
+				break;
+	}
+	*seen = event_gen;
+}
+
 enum trans_state
 {
 	TRANS_ACTIVE = -2,
@@ -137,31 +268,42 @@ enum trans_state
 	TRANS_IDLE = 0
 };
 
+static double now_ms(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
 static void cb_common(const char *func, struct libusb_transfer *transfer)
 {
 	int *transfer_cnt = (int *)transfer->user_data;
+	int result;
 
 	if (transfer->status == LIBUSB_TRANSFER_CANCELLED)
 	{
 		if (debug_enabled)
 			fprintf(stderr, "[DEBUG] %s: transfer cancelled\n", func);
-		*transfer_cnt = TRANS_IDLE;
-		return;
+		result = TRANS_IDLE;
 	}
-
-	if (transfer->status != LIBUSB_TRANSFER_COMPLETED)
+	else if (transfer->status != LIBUSB_TRANSFER_COMPLETED)
 	{
 		fprintf(stderr, "\n%s: error: %s\n", func, libusb_error_name(transfer->status));
 		if (debug_enabled)
 			fprintf(stderr, "[DEBUG] %s: transfer failed with status %d\n", func, transfer->status);
-		*transfer_cnt = TRANS_ERR;
+		result = TRANS_ERR;
 	}
 	else
 	{
 		if (debug_enabled)
 			fprintf(stderr, "[DEBUG] %s: transfer completed, %d bytes\n", func, transfer->actual_length);
-		*transfer_cnt = transfer->actual_length;
+		result = transfer->actual_length;
 	}
+
+	ch341a_usb_lock();
+	*transfer_cnt = result;
+	ch341a_usb_signal();
+	ch341a_usb_unlock();
 }
 
 static void LIBUSB_CALL cb_out(struct libusb_transfer *transfer)
@@ -182,10 +324,22 @@ static void LIBUSB_CALL cb_in(struct libusb_transfer *transfer)
  */
 static unsigned int usb_timeout_for(unsigned int bytes)
 {
-	return USB_TIMEOUT + bytes / 8;
+	return USB_TIMEOUT + bytes / tuning.bytes_per_ms;
 }
 
-static int32_t usb_transfer(const char *func, unsigned int writecnt, unsigned int readcnt, const uint8_t *writearr, uint8_t *readarr)
+/* Move writecnt bytes out and readcnt bytes in. Buffers in more[] are queued
+ * as separate OUT transfers right behind writearr, so they reach the device in
+ * the same round trip without being merged into the last (possibly short)
+ * packet of the stream ahead of them. readcnt covers all of them.
+ *
+ * The device answers every stream packet with one IN packet, and an IN
+ * transfer ends on the first short packet it gets, so IN transfers have to
+ * line up with the stream packets. Without in_lens readcnt is one stream of
+ * full packets; otherwise in_lens[0..n_in-1] are the reply lengths of the
+ * separate streams in order, each starting with a fresh packet.
+ */
+static int32_t usb_transfer(const char *func, unsigned int writecnt, unsigned int readcnt, const uint8_t *writearr, uint8_t *readarr,
+			    const struct usb_out *more, unsigned int n_more, const unsigned int *in_lens, unsigned int n_in)
 {
 	if (handle == NULL)
 	{
@@ -201,6 +355,8 @@ static int32_t usb_transfer(const char *func, unsigned int writecnt, unsigned in
 
 #ifdef __EMSCRIPTEN__
 #define EM_USB_TIMEOUT 5000
+	(void)in_lens;
+	(void)n_in;
 
 	if (writecnt > 0 && readcnt > 0)
 	{
@@ -285,12 +441,38 @@ static int32_t usb_transfer(const char *func, unsigned int writecnt, unsigned in
 		}
 	}
 
+	for (unsigned int m = 0; m < n_more; m++)
+	{
+		int sent = 0;
+		int ret = libusb_bulk_transfer(handle, WRITE_EP,
+			(unsigned char *)more[m].buf, more[m].len, &sent, EM_USB_TIMEOUT);
+		if (ret)
+		{
+			fprintf(stderr, "%s: OUT transfer %u failed: %s\n",
+				func, m + 1, libusb_error_name(ret));
+			return -1;
+		}
+	}
+
 	if (debug_enabled)
 		fprintf(stderr, "[DEBUG] %s: transfer completed (wrote %u, read %u bytes)\n",
 			func, writecnt, readcnt);
 	return 0;
 #else
+	if (n_more > USB_OUT_MORE)
+	{
+		fprintf(stderr, "%s: too many queued OUT transfers (%u)\n", func, n_more);
+		return -1;
+	}
+
+	unsigned long seen;
+	ch341a_usb_lock();
+	seen = event_gen;
+
 	int state_out = TRANS_IDLE;
+	int state_more[USB_OUT_MORE] = {0};
+	int state_in[USB_IN_TRANSFERS] = {0};
+	unsigned int m;
 	transfer_out->buffer = (uint8_t *)writearr;
 	transfer_out->length = writecnt;
 	transfer_out->user_data = &state_out;
@@ -313,6 +495,24 @@ static int32_t usb_transfer(const char *func, unsigned int writecnt, unsigned in
 		}
 	}
 
+	for (m = 0; m < n_more; m++)
+	{
+		transfer_more[m]->buffer = (uint8_t *)more[m].buf;
+		transfer_more[m]->length = more[m].len;
+		transfer_more[m]->user_data = &state_more[m];
+		transfer_more[m]->timeout = timeout;
+		state_more[m] = TRANS_ACTIVE;
+		if (debug_enabled)
+			fprintf(stderr, "[DEBUG] %s: submitting OUT transfer %u (%u bytes)\n", func, m + 1, more[m].len);
+		int ret = libusb_submit_transfer(transfer_more[m]);
+		if (ret)
+		{
+			fprintf(stderr, "%s: failed to submit OUT transfer: %s\n", func, libusb_error_name(ret));
+			state_more[m] = TRANS_ERR;
+			goto err;
+		}
+	}
+
 	/* Handle all asynchronous packets as long as we have stuff to write or read.
 	 * The write(s) simply need to complete, but we need to schedule reads as long
 	 * as we are not done.
@@ -322,13 +522,26 @@ static int32_t usb_transfer(const char *func, unsigned int writecnt, unsigned in
 	unsigned int in_done = 0;
 	unsigned int in_active = 0;
 	unsigned int out_done = 0;
+	unsigned int in_unit = 0;
+	unsigned int unit_left = in_lens ? (n_in ? in_lens[0] : 0) : readcnt;
 	uint8_t *in_buf = readarr;
-	int state_in[USB_IN_TRANSFERS] = {0};
+	bool more_active;
+	/* Every transfer carries its own timeout, so this only catches replies
+	 * that were never asked for */
+	const double deadline = now_ms() + 2 * timeout;
 	do
 	{
 		while ((in_done + in_active) < readcnt && state_in[free_idx] == TRANS_IDLE)
 		{
-			unsigned int cur_todo = min(CH341_PACKET_LENGTH - 1, readcnt - in_done - in_active);
+			while (unit_left == 0 && in_lens && ++in_unit < n_in)
+				unit_left = in_lens[in_unit];
+			if (unit_left == 0)
+			{
+				fprintf(stderr, "%s: reply layout covers less than %u bytes\n", func, readcnt);
+				goto err;
+			}
+			unsigned int cur_todo = min(CH341_PACKET_LENGTH - 1, unit_left);
+			unit_left -= cur_todo;
 			transfer_ins[free_idx]->length = cur_todo;
 			transfer_ins[free_idx]->buffer = in_buf;
 			transfer_ins[free_idx]->user_data = &state_in[free_idx];
@@ -348,10 +561,15 @@ static int32_t usb_transfer(const char *func, unsigned int writecnt, unsigned in
 			in_buf += cur_todo;
 			in_active += cur_todo;
 			state_in[free_idx] = TRANS_ACTIVE;
-			free_idx = (free_idx + 1) % USB_IN_TRANSFERS;
+			free_idx = (free_idx + 1) % tuning.in_transfers;
 		}
 
-		libusb_handle_events_timeout(NULL, &(struct timeval){1, 0});
+		ch341a_usb_wait(&seen);
+		if (now_ms() > deadline)
+		{
+			fprintf(stderr, "%s: transfer timed out\n", func);
+			goto err;
+		}
 
 		if (out_done < writecnt)
 		{
@@ -363,6 +581,14 @@ static int32_t usb_transfer(const char *func, unsigned int writecnt, unsigned in
 				state_out = TRANS_IDLE;
 			}
 		}
+		more_active = false;
+		for (m = 0; m < n_more; m++)
+		{
+			if (state_more[m] == TRANS_ERR)
+				goto err;
+			if (state_more[m] == TRANS_ACTIVE)
+				more_active = true;
+		}
 		while (state_in[in_idx] != TRANS_IDLE && state_in[in_idx] != TRANS_ACTIVE)
 		{
 			if (state_in[in_idx] == TRANS_ERR)
@@ -370,9 +596,10 @@ static int32_t usb_transfer(const char *func, unsigned int writecnt, unsigned in
 			in_done += state_in[in_idx];
 			in_active -= state_in[in_idx];
 			state_in[in_idx] = TRANS_IDLE;
-			in_idx = (in_idx + 1) % USB_IN_TRANSFERS;
+			in_idx = (in_idx + 1) % tuning.in_transfers;
 		}
-	} while ((out_done < writecnt) || (in_done < readcnt));
+	} while ((out_done < writecnt) || (in_done < readcnt) || more_active);
+	ch341a_usb_unlock();
 
 	if (debug_enabled)
 		fprintf(stderr, "[DEBUG] %s: transfer completed successfully (wrote %u, read %u bytes)\n", func, out_done, in_done);
@@ -385,6 +612,12 @@ err:
 		if (libusb_cancel_transfer(transfer_out) != 0)
 			state_out = TRANS_ERR;
 	}
+	for (m = 0; m < n_more; m++)
+	{
+		if (state_more[m] == TRANS_ACTIVE)
+			if (libusb_cancel_transfer(transfer_more[m]) != 0)
+				state_more[m] = TRANS_ERR;
+	}
 	if (readcnt > 0)
 	{
 		unsigned int i;
@@ -401,6 +634,11 @@ err:
 		bool finished = true;
 		if ((writecnt > 0) && (state_out == TRANS_ACTIVE))
 			finished = false;
+		for (m = 0; m < n_more; m++)
+		{
+			if (state_more[m] == TRANS_ACTIVE)
+				finished = false;
+		}
 		if (readcnt > 0)
 		{
 			unsigned int i;
@@ -412,8 +650,9 @@ err:
 		}
 		if (finished)
 			break;
-		libusb_handle_events_timeout(NULL, &(struct timeval){1, 0});
+		ch341a_usb_wait(&seen);
 	}
+	ch341a_usb_unlock();
 	return -1;
 #endif
 }
@@ -437,7 +676,7 @@ int config_stream(unsigned int speed)
 	    CH341A_CMD_I2C_STM_SET | (speed & 0x7),
 	    CH341A_CMD_I2C_STM_END};
 
-	int32_t ret = usb_transfer(__func__, sizeof(buf), 0, buf, NULL);
+	int32_t ret = usb_transfer(__func__, sizeof(buf), 0, buf, NULL, NULL, 0, NULL, 0);
 	if (ret < 0)
 	{
 		fprintf(stderr, "Could not configure stream interface.\n"); // Use stderr
@@ -452,12 +691,28 @@ int config_stream(unsigned int speed)
 }
 
 /* ch341 requires LSB first, swap the bit order before send and after receive */
-static uint8_t swap_byte(uint8_t x)
+#define SWAP_R2(n) n, n + 2 * 64, n + 1 * 64, n + 3 * 64
+#define SWAP_R4(n) SWAP_R2(n), SWAP_R2(n + 2 * 16), SWAP_R2(n + 1 * 16), SWAP_R2(n + 3 * 16)
+#define SWAP_R6(n) SWAP_R4(n), SWAP_R4(n + 2 * 4), SWAP_R4(n + 1 * 4), SWAP_R4(n + 3 * 4)
+static const uint8_t swap_lut[256] = { SWAP_R6(0), SWAP_R6(2), SWAP_R6(1), SWAP_R6(3) };
+
+/* Bit-reverse len bytes from src to dst (which may be the same buffer).
+ * Eight bytes at a time go through 64-bit shift/mask steps, the rest
+ * through swap_lut. */
+static void swap_bytes(uint8_t *dst, const uint8_t *src, size_t len)
 {
-	x = ((x >> 1) & 0x55) | ((x << 1) & 0xaa);
-	x = ((x >> 2) & 0x33) | ((x << 2) & 0xcc);
-	x = ((x >> 4) & 0x0f) | ((x << 4) & 0xf0);
-	return x;
+	size_t i = 0;
+	for (; i + 8 <= len; i += 8)
+	{
+		uint64_t x;
+		memcpy(&x, src + i, 8);
+		x = ((x >> 1) & 0x5555555555555555ULL) | ((x & 0x5555555555555555ULL) << 1);
+		x = ((x >> 2) & 0x3333333333333333ULL) | ((x & 0x3333333333333333ULL) << 2);
+		x = ((x >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((x & 0x0F0F0F0F0F0F0F0FULL) << 4);
+		memcpy(dst + i, &x, 8);
+	}
+	for (; i < len; i++)
+		dst[i] = swap_lut[src[i]];
 }
 
 /* The assumed map between UIO command bits, pins on CH341A chip and pins on SPI chip:
@@ -474,33 +729,39 @@ static uint8_t swap_byte(uint8_t x)
  *	D7/22	SO/2	(DIN)
  */
 
-int enable_pins(bool enable)
+/* Longest UIO sequence ch341a_uio_cs() can emit */
+#define CH341A_UIO_CS_MAX_LEN 9
+
+/* Encode the UIO stream that selects (CS low, pins driven) or deselects
+ * (outputs released, CS pulled high) the flash. Returns the encoded length.
+ */
+static unsigned int ch341a_uio_cs(uint8_t *buf, bool enable)
 {
-	if (debug_enabled)
-		fprintf(stderr, "[DEBUG] enable_pins: %sabling output pins\n", enable ? "en" : "dis");
+	uint8_t *ptr = buf;
 
+	*ptr++ = CH341A_CMD_UIO_STREAM;
 #ifdef __EMSCRIPTEN__
-	uint8_t buf[] = {
-	    CH341A_CMD_UIO_STREAM,
-	    CH341A_CMD_UIO_STM_OUT | (enable ? CH341A_UIO_STATE_CS0_LOW_SCK_LOW : CH341A_UIO_STATE_CS_HIGH_SCK_LOW),
-	    CH341A_CMD_UIO_STM_DIR | (enable ? CH341A_UIO_DIR_ALL_OUTPUT : CH341A_UIO_DIR_INPUT),
-	    CH341A_CMD_UIO_STM_END,
-	};
+	*ptr++ = CH341A_CMD_UIO_STM_OUT | (enable ? CH341A_UIO_STATE_CS0_LOW_SCK_LOW : CH341A_UIO_STATE_CS_HIGH_SCK_LOW);
 #else
-	uint8_t buf[] = {
-	    CH341A_CMD_UIO_STREAM,
-	    CH341A_CMD_UIO_STM_OUT | CH341A_UIO_STATE_CS_HIGH_SCK_LOW,
-	    CH341A_CMD_UIO_STM_OUT | CH341A_UIO_STATE_CS_HIGH_SCK_LOW,
-	    CH341A_CMD_UIO_STM_OUT | CH341A_UIO_STATE_CS_HIGH_SCK_LOW,
-	    CH341A_CMD_UIO_STM_OUT | CH341A_UIO_STATE_CS_HIGH_SCK_LOW,
-	    CH341A_CMD_UIO_STM_OUT | CH341A_UIO_STATE_CS_HIGH_SCK_LOW,
-	    CH341A_CMD_UIO_STM_OUT | CH341A_UIO_STATE_CS0_LOW_SCK_LOW,
-	    CH341A_CMD_UIO_STM_DIR | (enable ? CH341A_UIO_DIR_ALL_OUTPUT : CH341A_UIO_DIR_INPUT),
-	    CH341A_CMD_UIO_STM_END,
-	};
+	unsigned int i;
+	for (i = 0; i < 5; i++)
+		*ptr++ = CH341A_CMD_UIO_STM_OUT | CH341A_UIO_STATE_CS_HIGH_SCK_LOW;
+	*ptr++ = CH341A_CMD_UIO_STM_OUT | CH341A_UIO_STATE_CS0_LOW_SCK_LOW;
 #endif
+	*ptr++ = CH341A_CMD_UIO_STM_DIR | (enable ? CH341A_UIO_DIR_ALL_OUTPUT : CH341A_UIO_DIR_INPUT);
+	*ptr++ = CH341A_CMD_UIO_STM_END;
+	return ptr - buf;
+}
 
-	int32_t ret = usb_transfer(__func__, sizeof(buf), 0, buf, NULL);
+int enable_pins(bool enable)
+{
+	if (debug_enabled)
+		fprintf(stderr, "[DEBUG] enable_pins: %sabling output pins\n", enable ? "en" : "dis");
+
+	uint8_t buf[CH341A_UIO_CS_MAX_LEN];
+	unsigned int len = ch341a_uio_cs(buf, enable);
+
+	int32_t ret = usb_transfer(__func__, len, 0, buf, NULL, NULL, 0, NULL, 0);
 	if (ret < 0)
 	{
 		fprintf(stderr, "Could not %sable output pins.\n", enable ? "en" : "dis");
@@ -514,7 +775,39 @@ int enable_pins(bool enable)
 	return ret;
 }
 
-static int ch341a_spi_send_stream(unsigned int writecnt, unsigned int readcnt, const unsigned char *writearr, unsigned char *readarr)
+/* Pack writecnt bytes followed by readcnt 0xFF fill bytes into SPI stream
+ * packets, 31 payload bytes per packet.
+ */
+static void ch341a_fill_packets(uint8_t (*wbuf)[CH341_PACKET_LENGTH], size_t packets, unsigned int writecnt, unsigned int readcnt,
+				const unsigned char *writearr)
+{
+	unsigned int write_left = writecnt;
+	unsigned int read_left = readcnt;
+	unsigned int p;
+	for (p = 0; p < packets; p++)
+	{
+		unsigned int write_now = min(CH341_PACKET_LENGTH - 1, write_left);
+		unsigned int read_now = min((CH341_PACKET_LENGTH - 1) - write_now, read_left);
+		uint8_t *ptr = wbuf[p];
+		*ptr++ = CH341A_CMD_SPI_STREAM;
+		swap_bytes(ptr, writearr, write_now);
+		ptr += write_now;
+		writearr += write_now;
+		if (read_now)
+		{
+			memset(ptr, 0xFF, read_now);
+			read_left -= read_now;
+		}
+		write_left -= write_now;
+	}
+}
+
+/* Chip-select framing for ch341a_spi_send_stream() */
+#define CH341_CS_ASSERT 0x01   /* select the flash in the stream's lead packet */
+#define CH341_CS_DEASSERT 0x02 /* deselect it in a tail queued behind the stream */
+
+static int ch341a_spi_send_stream(unsigned int writecnt, unsigned int readcnt, const unsigned char *writearr, unsigned char *readarr,
+				  unsigned int cs)
 {
 	int32_t ret = 0;
 
@@ -540,30 +833,25 @@ static int ch341a_spi_send_stream(unsigned int writecnt, unsigned int readcnt, c
 	uint8_t (*wbuf)[CH341_PACKET_LENGTH] = em_safe_wbuf;
 	uint8_t *rbuf = em_safe_rbuf;
 #else
-	uint8_t wbuf[packets + 1][CH341_PACKET_LENGTH];
-	uint8_t rbuf[writecnt + readcnt];
+	if (packets + 1 > CH341_ARENA_PACKETS || writecnt + readcnt > CH341_ARENA_RLEN) {
+		fprintf(stderr, "ch341a_spi_send_command: transfer too large for packet arena\n");
+		return -1;
+	}
+	uint8_t (*wbuf)[CH341_PACKET_LENGTH] = (uint8_t (*)[CH341_PACKET_LENGTH])arena;
+	uint8_t *rbuf = arena + CH341_ARENA_WLEN;
 #endif
 	memset(wbuf[0], 0, CH341_PACKET_LENGTH);
+	/* The lead packet is otherwise dead padding, so the CS-low UIO sequence
+	 * rides in it for free. */
+	if (cs & CH341_CS_ASSERT)
+		ch341a_uio_cs(wbuf[0], true);
 
-	unsigned int write_left = writecnt;
-	unsigned int read_left = readcnt;
-	unsigned int p;
-	for (p = 0; p < packets; p++)
-	{
-		unsigned int write_now = min(CH341_PACKET_LENGTH - 1, write_left);
-		unsigned int read_now = min((CH341_PACKET_LENGTH - 1) - write_now, read_left);
-		uint8_t *ptr = wbuf[p + 1];
-		*ptr++ = CH341A_CMD_SPI_STREAM;
-		unsigned int i;
-		for (i = 0; i < write_now; ++i)
-			*ptr++ = swap_byte(*writearr++);
-		if (read_now)
-		{
-			memset(ptr, 0xFF, read_now);
-			read_left -= read_now;
-		}
-		write_left -= write_now;
-	}
+	uint8_t tail[CH341A_UIO_CS_MAX_LEN];
+	struct usb_out more = { tail, 0 };
+	if (cs & CH341_CS_DEASSERT)
+		more.len = ch341a_uio_cs(tail, false);
+
+	ch341a_fill_packets(&wbuf[1], packets, writecnt, readcnt, writearr);
 
 #ifdef __EMSCRIPTEN__
 	if (readcnt == 0 && writecnt > 0) {
@@ -599,49 +887,500 @@ static int ch341a_spi_send_stream(unsigned int writecnt, unsigned int readcnt, c
 	} else
 #endif
 	ret = usb_transfer(__func__, CH341_PACKET_LENGTH + packets + writecnt + readcnt,
-			   writecnt + readcnt, wbuf[0], rbuf);
+			   writecnt + readcnt, wbuf[0], rbuf, &more, more.len ? 1 : 0, NULL, 0);
 
 	if (ret < 0)
 		return -1;
 
-	unsigned int i;
-	unsigned char *read_start = readarr;
-	for (i = 0; i < readcnt; i++)
-	{
-		*readarr++ = swap_byte(rbuf[writecnt + i]);
-	}
-	trace_dump("SPI READ", read_start, readcnt);
+	swap_bytes(readarr, rbuf + writecnt, readcnt);
+	trace_dump("SPI READ", readarr, readcnt);
 
 	return 0;
 }
 
-int ch341a_spi_send_command(unsigned int writecnt, unsigned int readcnt, const unsigned char *writearr, unsigned char *readarr)
+static int ch341a_spi_send_split(unsigned int writecnt, unsigned int readcnt, const unsigned char *writearr, unsigned char *readarr,
+				 unsigned int cs)
 {
 	/* Split streams too long to complete inside a single transfer deadline. The
 	 * flash cannot tell the difference: CS stays asserted throughout, so the
 	 * sub-transactions clock out as one uninterrupted SPI stream. Write bytes
-	 * are drained first so that reads always trail the command they belong to. */
-	while (writecnt > CH341_MAX_XFER_BYTES)
+	 * are drained first so that reads always trail the command they belong to.
+	 * CS framing goes on the first and last pieces only. */
+	unsigned int lead = cs & CH341_CS_ASSERT;
+
+	const unsigned int xfer = tuning.xfer_bytes;
+
+	while (writecnt > xfer)
 	{
-		if (ch341a_spi_send_stream(CH341_MAX_XFER_BYTES, 0, writearr, NULL))
+		if (ch341a_spi_send_stream(xfer, 0, writearr, NULL, lead))
 			return -1;
-		writearr += CH341_MAX_XFER_BYTES;
-		writecnt -= CH341_MAX_XFER_BYTES;
+		lead = 0;
+		writearr += xfer;
+		writecnt -= xfer;
 	}
 
-	while (writecnt + readcnt > CH341_MAX_XFER_BYTES)
+	while (writecnt + readcnt > xfer)
 	{
-		unsigned int read_now = CH341_MAX_XFER_BYTES - writecnt;
-		if (ch341a_spi_send_stream(writecnt, read_now, writearr, readarr))
+		unsigned int read_now = xfer - writecnt;
+		if (ch341a_spi_send_stream(writecnt, read_now, writearr, readarr, lead))
 			return -1;
+		lead = 0;
 		readarr += read_now;
 		readcnt -= read_now;
 		writecnt = 0;
 	}
 
-	return ch341a_spi_send_stream(writecnt, readcnt, writearr, readarr);
+	return ch341a_spi_send_stream(writecnt, readcnt, writearr, readarr, lead | (cs & CH341_CS_DEASSERT));
+}
+
+int ch341a_spi_send_command(unsigned int writecnt, unsigned int readcnt, const unsigned char *writearr, unsigned char *readarr)
+{
+	return ch341a_spi_send_split(writecnt, readcnt, writearr, readarr, 0);
+}
+
+#ifndef __EMSCRIPTEN__
+/* One CS-framed command in a single round trip: the CS-low UIO sequence leads
+ * the SPI stream packets and the CS-high sequence follows as a queued tail,
+ * instead of three separately awaited bulk transfers. */
+static int ch341a_spi_transaction(unsigned int writecnt, unsigned int readcnt, const unsigned char *writearr, unsigned char *readarr)
+{
+	if (ch341a_spi_send_split(writecnt, readcnt, writearr, readarr, CH341_CS_ASSERT | CH341_CS_DEASSERT))
+	{
+		/* Don't leave the flash selected after a partial stream */
+		enable_pins(false);
+		return -1;
+	}
+	return 0;
+}
+
+/* Write-only commands flushed by the controller's write-combining queue. A
+ * short packet ends a bulk transfer, so every command needs its own OUT
+ * transfer (a lead packet that re-pulses CS, then its stream packets); the
+ * whole batch and a final CS-high tail are submitted before waiting, so the
+ * batch still costs one round trip. Each command's echo comes back as its
+ * own run of IN packets, which usb_transfer() is told about; it is discarded.
+ */
+static int ch341a_spi_transaction_batch(unsigned int count, const unsigned int *writecnts, const unsigned char *writearr)
+{
+	if (handle == NULL)
+		return -1;
+
+	while (count > 0)
+	{
+		unsigned int n = 0;
+		size_t rows = 0;
+		unsigned int total = 0;
+		unsigned int i;
+
+		/* Take as many commands as the arena and the OUT transfers hold */
+		while (n < min(count, USB_OUT_MORE))
+		{
+			size_t need = 1 + (writecnts[n] + CH341_PACKET_LENGTH - 2) / (CH341_PACKET_LENGTH - 1);
+			if (rows + need > CH341_ARENA_PACKETS || total + writecnts[n] > CH341_ARENA_RLEN)
+				break;
+			rows += need;
+			total += writecnts[n];
+			n++;
+		}
+		if (n == 0)
+		{
+			fprintf(stderr, "%s: command too large for packet arena\n", __func__);
+			return -1;
+		}
+
+		uint8_t (*wbuf)[CH341_PACKET_LENGTH] = (uint8_t (*)[CH341_PACKET_LENGTH])arena;
+		uint8_t *rbuf = arena + CH341_ARENA_WLEN;
+		uint8_t tail[CH341A_UIO_CS_MAX_LEN];
+		struct usb_out more[USB_OUT_MORE];
+		unsigned int in_lens[USB_OUT_MORE];
+		unsigned int lead_len = 0;
+		size_t row = 0;
+
+		for (i = 0; i < n; i++)
+		{
+			size_t packets = (writecnts[i] + CH341_PACKET_LENGTH - 2) / (CH341_PACKET_LENGTH - 1);
+			unsigned int len = CH341_PACKET_LENGTH + packets + writecnts[i];
+
+			trace_dump("SPI WRITE", writearr, writecnts[i]);
+			memset(wbuf[row], 0, CH341_PACKET_LENGTH);
+			ch341a_uio_cs(wbuf[row], true);
+			ch341a_fill_packets(&wbuf[row + 1], packets, writecnts[i], 0, writearr);
+			in_lens[i] = writecnts[i];
+			if (i == 0)
+				lead_len = len;
+			else
+				more[i - 1] = (struct usb_out){ wbuf[row], len };
+			row += 1 + packets;
+			writearr += writecnts[i];
+		}
+		more[n - 1] = (struct usb_out){ tail, ch341a_uio_cs(tail, false) };
+
+		if (debug_enabled)
+			fprintf(stderr, "[DEBUG] ch341a_spi_transaction_batch: %u commands, %u bytes\n", n, total);
+
+		if (usb_transfer(__func__, lead_len, total, wbuf[0], rbuf, more, n, in_lens, n) < 0)
+		{
+			enable_pins(false);
+			return -1;
+		}
+		count -= n;
+		writecnts += n;
+	}
+	return 0;
+}
+
+/* Status polling: count copies of one short command, each CS framed and in
+ * its own OUT transfer like a batch entry, queued behind a single CS-high
+ * tail, so a run of up to USB_OUT_MORE samples costs one round trip. The next
+ * repetition's lead packet deselects the flash before selecting it again.
+ */
+static int ch341a_spi_transaction_repeat(unsigned int count, unsigned int writecnt, unsigned int readcnt,
+					 const unsigned char *writearr, unsigned char *readarr)
+{
+	const unsigned int step = writecnt + readcnt;
+
+	if (handle == NULL)
+		return -1;
+	if (step == 0 || step > CH341_PACKET_LENGTH - 1)
+	{
+		fprintf(stderr, "%s: command does not fit one stream packet\n", __func__);
+		return -1;
+	}
+
+	trace_dump("SPI WRITE", writearr, writecnt);
+
+	while (count > 0)
+	{
+		unsigned int n = min(count, USB_OUT_MORE);
+		uint8_t (*wbuf)[CH341_PACKET_LENGTH] = (uint8_t (*)[CH341_PACKET_LENGTH])arena;
+		uint8_t *rbuf = arena + CH341_ARENA_WLEN;
+		uint8_t tail[CH341A_UIO_CS_MAX_LEN];
+		struct usb_out more[USB_OUT_MORE];
+		unsigned int in_lens[USB_OUT_MORE];
+		unsigned int i;
+
+		for (i = 0; i < n; i++)
+		{
+			memset(wbuf[2 * i], 0, CH341_PACKET_LENGTH);
+			ch341a_uio_cs(wbuf[2 * i], true);
+			ch341a_fill_packets(&wbuf[2 * i + 1], 1, writecnt, readcnt, writearr);
+			in_lens[i] = step; /* one reply packet per sample, at rbuf + i * step */
+			if (i > 0)
+				more[i - 1] = (struct usb_out){ wbuf[2 * i], CH341_PACKET_LENGTH + 1 + step };
+		}
+		more[n - 1] = (struct usb_out){ tail, ch341a_uio_cs(tail, false) };
+
+		if (debug_enabled)
+			fprintf(stderr, "[DEBUG] ch341a_spi_transaction_repeat: %u samples\n", n);
+
+		if (usb_transfer(__func__, CH341_PACKET_LENGTH + 1 + step, n * step, wbuf[0], rbuf, more, n, in_lens, n) < 0)
+		{
+			enable_pins(false);
+			return -1;
+		}
+		for (i = 0; i < n; i++)
+			swap_bytes(readarr + i * readcnt, rbuf + i * step + writecnt, readcnt);
+		trace_dump("SPI READ", readarr, n * readcnt);
+		readarr += n * readcnt;
+		count -= n;
+	}
+	return 0;
+}
+
+/* Spread a nibble's bits to the even bit positions of a byte */
+static const uint8_t dual_spread[16] = {
+	0x00, 0x01, 0x04, 0x05, 0x10, 0x11, 0x14, 0x15,
+	0x40, 0x41, 0x44, 0x45, 0x50, 0x51, 0x54, 0x55
+};
+
+/* In double mode each pair of stream bytes shares eight clocks: the first
+ * samples D7 (the flash's IO1, odd data bits), the second D6 (IO0, even
+ * bits). Weave every pair back into the two flash bytes it carries. */
+static void ch341a_dual_decode(uint8_t *buf, size_t len)
+{
+	size_t i;
+
+	for (i = 0; i + 1 < len; i += 2)
+	{
+		uint8_t io1 = buf[i];
+		uint8_t io0 = buf[i + 1];
+		buf[i] = (dual_spread[io1 >> 4] << 1) | dual_spread[io0 >> 4];
+		buf[i + 1] = (dual_spread[io1 & 0xF] << 1) | dual_spread[io0 & 0xF];
+	}
+}
+
+/* Dual-output read. The command goes out on D5 as the first byte of each
+ * pair with D4 idle high, so it still clocks one bit per cycle; the data
+ * phase then returns two flash bytes per pair. Needs the flash's IO0 on D6,
+ * which the controller verifies before trusting the result. */
+#define CH341_DUAL_CMD_MAX 8
+
+static int ch341a_spi_read_dual(unsigned int writecnt, unsigned int readcnt, const unsigned char *writearr, unsigned char *readarr)
+{
+	uint8_t cmd[2 * CH341_DUAL_CMD_MAX];
+	uint8_t pair[2];
+	/* Data comes in byte pairs; an odd last byte gets a pair of its own,
+	 * clocked in the same CS frame */
+	unsigned int even = readcnt & ~1u;
+	unsigned int i;
+	int ret;
+
+	if (writecnt > CH341_DUAL_CMD_MAX)
+		return -1;
+	for (i = 0; i < writecnt; i++)
+	{
+		cmd[2 * i] = writearr[i];
+		cmd[2 * i + 1] = 0xFF;
+	}
+
+	if (config_stream(CH341A_STM_I2C_750K | CH341A_STM_SPI_DBL) < 0)
+		return -1;
+	ret = ch341a_spi_send_split(2 * writecnt, even, cmd, readarr,
+				    even == readcnt ? CH341_CS_ASSERT | CH341_CS_DEASSERT : CH341_CS_ASSERT);
+	if (ret == 0 && even != readcnt)
+		ret = ch341a_spi_send_split(0, sizeof(pair), cmd, pair, CH341_CS_DEASSERT);
+	if (ret)
+		enable_pins(false);
+	if (config_stream(CH341A_STM_I2C_750K) < 0)
+		ret = -1;
+	if (ret == 0)
+	{
+		ch341a_dual_decode(readarr, even);
+		if (even != readcnt)
+		{
+			ch341a_dual_decode(pair, sizeof(pair));
+			readarr[even] = pair[0];
+		}
+	}
+	return ret;
+}
+
+/* Measure round-trip latency and payload throughput, then derive the IN
+ * window, split size and timeout rate. The streams are clocked with the pins
+ * released, so the flash sees CS high and ignores them.
+ */
+static int ch341a_calibrate(void)
+{
+	static const unsigned int windows[] = { 4, 8, 16, USB_IN_TRANSFERS };
+	static uint8_t buf[CH341_MAX_XFER_BYTES];
+	const unsigned int n_windows = sizeof(windows) / sizeof(windows[0]);
+	double rate[sizeof(windows) / sizeof(windows[0])];
+	double latency, best = 0, t0;
+	unsigned int i;
+
+	if (enable_pins(false) < 0)
+		return -1;
+
+	tuning.xfer_bytes = CH341_MAX_XFER_BYTES;
+	tuning.in_transfers = USB_IN_TRANSFERS;
+
+	t0 = now_ms();
+	for (i = 0; i < 8; i++)
+		if (ch341a_spi_send_stream(0, 1, NULL, buf, 0))
+			return -1;
+	latency = (now_ms() - t0) / 8;
+
+	for (i = 0; i < n_windows; i++)
+	{
+		tuning.in_transfers = windows[i];
+		t0 = now_ms();
+		if (ch341a_spi_send_stream(0, sizeof(buf), NULL, buf, 0))
+			return -1;
+		rate[i] = sizeof(buf) / (now_ms() - t0);
+		if (rate[i] > best)
+			best = rate[i];
+		if (debug_enabled)
+			fprintf(stderr, "[DEBUG] ch341a_calibrate: %u IN transfers: %.1f bytes/ms\n", windows[i], rate[i]);
+	}
+
+	/* Fewest transfers in flight that get within 5% of the best rate */
+	for (i = 0; i < n_windows && rate[i] < best * 0.95; i++)
+		;
+	tuning.in_transfers = windows[i];
+
+	/* Keep one split stream inside a quarter of the base timeout */
+	double budget = (USB_TIMEOUT / 4 - latency) * best;
+	unsigned int xfer = budget > CH341_MAX_XFER_BYTES ? CH341_MAX_XFER_BYTES : (unsigned int)budget;
+	xfer &= ~1023u;
+	tuning.xfer_bytes = xfer < 1024 ? 1024 : xfer;
+
+	/* Timeouts assume a quarter of the measured rate, but never allow less
+	 * time than the defaults */
+	if (best / 4 >= CH341_BYTES_PER_MS)
+		tuning.bytes_per_ms = CH341_BYTES_PER_MS;
+	else
+		tuning.bytes_per_ms = best >= 4 ? (unsigned int)(best / 4) : 1;
+
+	if (debug_enabled)
+		fprintf(stderr, "[DEBUG] ch341a_calibrate: latency %.2f ms, rate %.1f bytes/ms\n", latency, best);
+
+	return enable_pins(true);
 }
 
+/* Calibration cache: one line per programmer, "<bus>-<ports>@<bcdDevice>
+ * <in_transfers> <xfer_bytes> <bytes_per_ms>", under $XDG_CACHE_HOME/scriba
+ * (or ~/.cache/scriba).
+ */
+static int tuning_path(char *path, size_t len, bool create)
+{
+	const char *base = getenv("XDG_CACHE_HOME");
+	int n;
+
+	if (base && *base)
+		n = snprintf(path, len, "%s", base);
+	else if ((base = getenv("HOME")) && *base)
+		n = snprintf(path, len, "%s/.cache", base);
+	else
+		return -1;
+	if (n < 0 || (size_t)n >= len)
+		return -1;
+	if (create)
+		mkdir(path, 0755);
+	n += snprintf(path + n, len - n, "/scriba");
+	if (create && mkdir(path, 0755) < 0 && errno != EEXIST)
+		return -1;
+	n += snprintf(path + n, len - n, "/ch341a-tuning");
+	return (size_t)n < len ? 0 : -1;
+}
+
+static bool tuning_load(const char *key)
+{
+	char path[512], line[256], k[128];
+	struct ch341a_tuning t;
+	bool found = false;
+	FILE *fp;
+
+	if (tuning_path(path, sizeof(path), false) < 0 || !(fp = fopen(path, "r")))
+		return false;
+	while (!found && fgets(line, sizeof(line), fp))
+	{
+		if (sscanf(line, "%127s %u %u %u", k, &t.in_transfers, &t.xfer_bytes, &t.bytes_per_ms) != 4 ||
+		    strcmp(k, key) != 0)
+			continue;
+		if (t.in_transfers < 1 || t.in_transfers > USB_IN_TRANSFERS ||
+		    t.xfer_bytes < 1024 || t.xfer_bytes > CH341_MAX_XFER_BYTES ||
+		    t.bytes_per_ms < 1 || t.bytes_per_ms > CH341_BYTES_PER_MS)
+			break;
+		tuning = t;
+		found = true;
+	}
+	fclose(fp);
+	return found;
+}
+
+static void tuning_save(const char *key)
+{
+	char path[512], tmp[520], line[256], k[128];
+	FILE *in, *out;
+
+	if (tuning_path(path, sizeof(path), true) < 0)
+		return;
+	snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+	if (!(out = fopen(tmp, "w")))
+		return;
+	if ((in = fopen(path, "r")))
+	{
+		while (fgets(line, sizeof(line), in))
+			if (sscanf(line, "%127s", k) == 1 && strcmp(k, key) != 0)
+				fputs(line, out);
+		fclose(in);
+	}
+	fprintf(out, "%s %u %u %u\n", key, tuning.in_transfers, tuning.xfer_bytes, tuning.bytes_per_ms);
+	if (fclose(out) != 0 || rename(tmp, path) != 0)
+	{
+		remove(tmp);
+		if (debug_enabled)
+			fprintf(stderr, "[DEBUG] ch341a_tune: could not save %s\n", path);
+	}
+}
+
+/* Apply cached settings for this programmer, or the defaults when there are
+ * none; with --calibrate, measure and cache them instead */
+static void ch341a_tune(struct libusb_device *dev, uint16_t bcd)
+{
+	char key[64];
+	uint8_t ports[8];
+	int n = libusb_get_port_numbers(dev, ports, sizeof(ports));
+	int off = snprintf(key, sizeof(key), "%u", libusb_get_bus_number(dev));
+	int i;
+
+	for (i = 0; i < n; i++)
+		off += snprintf(key + off, sizeof(key) - off, "%c%u", i ? '.' : '-', ports[i]);
+	snprintf(key + off, sizeof(key) - off, "@%04x", bcd);
+
+	if (!tuning_forced)
+	{
+		if (tuning_load(key))
+		{
+			if (debug_enabled)
+				fprintf(stderr, "[DEBUG] ch341a_tune: %s: cached %u IN transfers, %u-byte streams, %u bytes/ms\n",
+					key, tuning.in_transfers, tuning.xfer_bytes, tuning.bytes_per_ms);
+		}
+		else if (debug_enabled)
+			fprintf(stderr, "[DEBUG] ch341a_tune: %s: no cached settings, using defaults\n", key);
+		return;
+	}
+
+	if (ch341a_calibrate() < 0)
+	{
+		fprintf(stderr, "CH341A calibration failed, using defaults\n");
+		tuning = (struct ch341a_tuning){ USB_IN_TRANSFERS, CH341_MAX_XFER_BYTES, CH341_BYTES_PER_MS };
+		enable_pins(true);
+		return;
+	}
+	if (debug_enabled)
+		fprintf(stderr, "[DEBUG] ch341a_tune: calibrated %s: %u IN transfers, %u-byte streams, %u bytes/ms\n",
+			key, tuning.in_transfers, tuning.xfer_bytes, tuning.bytes_per_ms);
+	tuning_save(key);
+}
+#endif
+
+/* Calibrate at the next init and cache the result; otherwise cached settings
+ * or the defaults are used */
+void ch341a_spi_force_calibration(void)
+{
+	tuning_forced = true;
+}
+
+#ifndef __EMSCRIPTEN__
+static int arena_alloc(void)
+{
+	const size_t size = CH341_ARENA_WLEN + CH341_ARENA_RLEN;
+
+#if LIBUSB_API_VERSION >= 0x01000105
+	arena = libusb_dev_mem_alloc(handle, size);
+	if (arena)
+	{
+		arena_devmem = true;
+		if (debug_enabled)
+			fprintf(stderr, "[DEBUG] ch341a_spi_init: packet arena in device memory (%zu bytes)\n", size);
+		return 0;
+	}
+#endif
+	arena_devmem = false;
+	arena = malloc(size);
+	if (arena == NULL)
+		return -1;
+	if (debug_enabled)
+		fprintf(stderr, "[DEBUG] ch341a_spi_init: packet arena on heap (%zu bytes)\n", size);
+	return 0;
+}
+
+static void arena_free(void)
+{
+	if (arena == NULL)
+		return;
+#if LIBUSB_API_VERSION >= 0x01000105
+	if (arena_devmem)
+		libusb_dev_mem_free(handle, arena, CH341_ARENA_WLEN + CH341_ARENA_RLEN);
+	else
+#endif
+		free(arena);
+	arena = NULL;
+	arena_devmem = false;
+}
+#endif
+
 int ch341a_spi_shutdown(void)
 {
 	if (debug_enabled)
@@ -656,14 +1395,21 @@ int ch341a_spi_shutdown(void)
 
 	enable_pins(false);
 #ifndef __EMSCRIPTEN__
+	event_thread_join();
 	libusb_free_transfer(transfer_out);
 	transfer_out = NULL;
 	int i;
+	for (i = 0; i < USB_OUT_MORE; i++)
+	{
+		libusb_free_transfer(transfer_more[i]);
+		transfer_more[i] = NULL;
+	}
 	for (i = 0; i < USB_IN_TRANSFERS; i++)
 	{
 		libusb_free_transfer(transfer_ins[i]);
 		transfer_ins[i] = NULL;
 	}
+	arena_free();
 #endif
 	libusb_release_interface(handle, 0);
 	libusb_close(handle);
@@ -815,16 +1561,26 @@ int ch341a_spi_init(void)
 	if (debug_enabled)
 		fprintf(stderr, "[DEBUG] ch341a_spi_init: allocating USB transfer structures\n");
 
+	int i;
 	transfer_out = libusb_alloc_transfer(0);
 	if (!transfer_out)
 	{
 		fprintf(stderr, "Failed to alloc libusb OUT transfer\n");
 		if (debug_enabled)
 			fprintf(stderr, "[DEBUG] ch341a_spi_init: OUT transfer allocation failed\n");
-		goto release_interface;
+		goto dealloc_transfers;
+	}
+
+	for (i = 0; i < USB_OUT_MORE; i++)
+	{
+		transfer_more[i] = libusb_alloc_transfer(0);
+		if (transfer_more[i] == NULL)
+		{
+			fprintf(stderr, "Failed to alloc libusb OUT transfer %d\n", i + 1);
+			goto dealloc_transfers;
+		}
 	}
 
-	int i;
 	for (i = 0; i < USB_IN_TRANSFERS; i++)
 	{
 		transfer_ins[i] = libusb_alloc_transfer(0);
@@ -838,12 +1594,22 @@ int ch341a_spi_init(void)
 	}
 
 	if (debug_enabled)
-		fprintf(stderr, "[DEBUG] ch341a_spi_init: %d USB transfer structures allocated successfully\n", USB_IN_TRANSFERS + 1);
+		fprintf(stderr, "[DEBUG] ch341a_spi_init: %d USB transfer structures allocated successfully\n", USB_IN_TRANSFERS + USB_OUT_MORE + 1);
+
+	if (arena_alloc() < 0)
+	{
+		fprintf(stderr, "Failed to alloc packet buffers\n");
+		goto dealloc_transfers;
+	}
 
 	/* We use these helpers but don't fill the actual buffer yet. */
 	libusb_fill_bulk_transfer(transfer_out, handle, WRITE_EP, NULL, 0, cb_out, NULL, USB_TIMEOUT);
+	for (i = 0; i < USB_OUT_MORE; i++)
+		libusb_fill_bulk_transfer(transfer_more[i], handle, WRITE_EP, NULL, 0, cb_out, NULL, USB_TIMEOUT);
 	for (i = 0; i < USB_IN_TRANSFERS; i++)
 		libusb_fill_bulk_transfer(transfer_ins[i], handle, READ_EP, NULL, 0, cb_in, NULL, USB_TIMEOUT);
+
+	event_thread_start();
 #else
 	int i = 0;
 #endif
@@ -858,6 +1624,10 @@ int ch341a_spi_init(void)
 		goto dealloc_transfers;
 	}
 
+#ifndef __EMSCRIPTEN__
+	ch341a_tune(dev, desc.bcdDevice);
+#endif
+
 	if (debug_enabled)
 		fprintf(stderr, "[DEBUG] ch341a_spi_init: initialization complete\n");
 
@@ -865,6 +1635,7 @@ int ch341a_spi_init(void)
 
  dealloc_transfers:
 #ifndef __EMSCRIPTEN__
+	event_thread_join();
 	for (i = 0; i < USB_IN_TRANSFERS; i++)
 	{
 		if (transfer_ins[i] == NULL)
@@ -872,8 +1643,14 @@ int ch341a_spi_init(void)
 		libusb_free_transfer(transfer_ins[i]);
 		transfer_ins[i] = NULL;
 	}
+	for (i = 0; i < USB_OUT_MORE; i++)
+	{
+		libusb_free_transfer(transfer_more[i]);
+		transfer_more[i] = NULL;
+	}
 	libusb_free_transfer(transfer_out);
 	transfer_out = NULL;
+	arena_free();
 #endif
  release_interface:
 	libusb_release_interface(handle, 0);
@@ -911,4 +1688,10 @@ const struct spi_programmer ch341a_programmer = {
 	.cs_select      = ch341a_cs_select,
 	.cs_deselect    = ch341a_cs_deselect,
 	.libusb_version = get_libusb_version,
+#ifndef __EMSCRIPTEN__
+	.transaction    = ch341a_spi_transaction,
+	.transaction_batch = ch341a_spi_transaction_batch,
+	.transaction_repeat = ch341a_spi_transaction_repeat,
+	.read_dual      = ch341a_spi_read_dual,
+#endif
 };
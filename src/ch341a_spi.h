@@ -38,5 +38,12 @@ int ch341a_spi_send_command(unsigned int writecnt, unsigned int readcnt, const u
 int enable_pins(bool enable);
 int config_stream(unsigned int speed);
 const char *get_libusb_version(void);
+void ch341a_spi_force_calibration(void);
+
+/* Completion waits on the USB event thread, shared with the I2C code */
+void ch341a_usb_lock(void);
+void ch341a_usb_unlock(void);
+void ch341a_usb_signal(void);
+void ch341a_usb_wait(unsigned long *seen);
 
 #endif /* __CH341_SPI_H__ */
@@ -0,0 +1,40 @@
+/*
+ * chipdb.h
+ * Lookup index over the chip tables, generated at build time by chipdb_gen.
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+#ifndef __CHIPDB_H__
+#define __CHIPDB_H__
+
+#include "types.h"
+
+/* One slot of a perfect hash over the keys of a chip table. The entries
+ * sharing the key are first .. first + count - 1 of the sorted NOR table, or
+ * of snand_index_order[] for NAND; count 0 marks an empty slot. */
+struct chipdb_slot
+{
+	u32 key;
+	u16 first;
+	u16 count;
+};
+
+/* NOR entries are keyed by manufacturer and the upper 16 bits of jedec_id,
+ * NAND entries by manufacturer and dev_id */
+#define CHIPDB_NOR_KEY(id, jedec) (((u32)(id) << 16) | ((u32)(jedec) >> 16))
+#define CHIPDB_NAND_KEY(mfr, dev) (((u32)(mfr) << 8) | (u32)(dev))
+
+static inline u32 chipdb_hash(u32 key, u32 mult, int bits)
+{
+	return (u32)(key * mult) >> (32 - bits);
+}
+
+/* The slot holding key, or NULL */
+static inline const struct chipdb_slot *chipdb_find(const struct chipdb_slot *slots,
+						     u32 mult, int bits, u32 key)
+{
+	const struct chipdb_slot *slot = &slots[chipdb_hash(key, mult, bits)];
+
+	return (slot->count && slot->key == key) ? slot : NULL;
+}
+
+#endif /* __CHIPDB_H__ */
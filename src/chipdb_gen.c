@@ -0,0 +1,320 @@
+/*
+ * chipdb_gen.c
+ * Build-time checker and indexer for the chip tables.
+ *
+ * Runs on the build host over the same table sources the programmer is
+ * built from. Every entry is validated and the build stops on the first
+ * run that finds a bad one, so an unsorted, duplicated, unreachable or
+ * malformed entry never ships. The NOR and NAND tables are then indexed
+ * with a collision-free multiplicative hash, which the probes include as
+ * snor_index.h and snand_index.h.
+ *
+ * Usage: chipdb_gen <snor_index.h> <snand_index.h>
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "chipdb.h"
+#include "spi_nor_flash.h"
+#include "spi_nand_flash.h"
+#ifdef EEPROM_SUPPORT
+#include "ch341a_i2c.h"
+#include "spi_eeprom.h"
+#include "bitbang_microwire.h"
+#endif
+
+#define CHIPDB_MAX_BITS 16
+
+extern const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[];
+size_t get_spi_nand_flash_table_size(void);
+
+static int errors;
+
+static void bad(const char *table, int i, const char *name, const char *what)
+{
+	fprintf(stderr, "chipdb: %s entry %d (%s): %s\n", table, i, name ? name : "?", what);
+	errors++;
+}
+
+static int pow2(unsigned long v)
+{
+	return v && !(v & (v - 1));
+}
+
+/*
+ * NOR: sorted by (id, jedec_id), sane geometry, and a way to address every
+ * byte of the chip. An entry repeating the previous id is an alias listed
+ * under another name: chip_prob() returns the first, so both must describe
+ * the same geometry, addressing mode and timings.
+ */
+static void check_nor(void)
+{
+	const char *t = "spi_nor_flash_tables.c";
+	size_t n = get_spi_nor_flash_table_size();
+	size_t i;
+
+	for (i = 0; i < n; i++) {
+		const struct chip_info *c = &chips_data[i], *p;
+		unsigned long long size = (unsigned long long)c->sector_size * c->n_sectors;
+
+		if (!c->name || !c->name[0])
+			bad(t, i, c->name, "no name");
+		if (c->id == 0x00 || c->id == 0xff)
+			bad(t, i, c->name, "manufacturer id 0x00/0xff reads back from an absent chip");
+		if (c->sector_size < 4096 || !pow2(c->sector_size))
+			bad(t, i, c->name, "sector size not a power of two of at least 4K");
+		if (!c->n_sectors)
+			bad(t, i, c->name, "no sectors");
+		if (c->addr4b < SNOR_ADDR3B || c->addr4b > SNOR_ADDR4B_OPCODES)
+			bad(t, i, c->name, "unknown addr4b mode");
+		if (size > 0x1000000 && c->addr4b == SNOR_ADDR3B)
+			bad(t, i, c->name, "larger than 16 MB without 4-byte addressing");
+		if (size > 0x100000000ULL)
+			bad(t, i, c->name, "larger than 4 GB");
+		if (!i)
+			continue;
+		p = &chips_data[i - 1];
+		if (c->id < p->id || (c->id == p->id && c->jedec_id < p->jedec_id))
+			bad(t, i, c->name, "not sorted by (id, jedec_id)");
+		else if (c->id == p->id && c->jedec_id == p->jedec_id &&
+			 (c->sector_size != p->sector_size || c->n_sectors != p->n_sectors))
+			bad(t, i, c->name, "same id as the previous entry but a different geometry");
+		else if (c->id == p->id && c->jedec_id == p->jedec_id &&
+			 (c->addr4b != p->addr4b || c->page_max_us != p->page_max_us ||
+			  c->erase_max_ms != p->erase_max_ms))
+			bad(t, i, c->name, "same id as the previous entry but a different addr4b mode or timing");
+	}
+}
+
+/*
+ * NAND: sane geometry and modes. An entry hidden behind an earlier one that
+ * spi_nand_probe() matches first is only allowed as an alias of it.
+ */
+static void check_nand(void)
+{
+	const char *t = "spi_nand_flash_tables.c";
+	size_t n = get_spi_nand_flash_table_size();
+	size_t i, j;
+
+	for (i = 0; i < n; i++) {
+		const struct SPI_NAND_FLASH_INFO_T *e = &spi_nand_flash_tables[i];
+
+		if (!e->ptr_name || !e->ptr_name[0])
+			bad(t, i, e->ptr_name, "no name");
+		if (e->mfr_id == 0x00 || e->mfr_id == 0xff)
+			bad(t, i, e->ptr_name, "manufacturer id 0x00/0xff reads back from an absent chip");
+		if (!pow2(e->page_size) || !pow2(e->erase_size) || !pow2(e->device_size) ||
+		    e->erase_size < e->page_size || e->device_size < e->erase_size)
+			bad(t, i, e->ptr_name, "page, block and chip sizes not nested powers of two");
+		if (!e->oob_size || e->oob_size >= e->page_size)
+			bad(t, i, e->ptr_name, "OOB size out of range");
+		if (e->dummy_mode >= SPI_NAND_FLASH_READ_DUMMY_BYTE_DEF_NO ||
+		    e->read_mode >= SPI_NAND_FLASH_READ_SPEED_MODE_DEF_NO ||
+		    e->write_mode >= SPI_NAND_FLASH_WRITE_SPEED_MODE_DEF_NO)
+			bad(t, i, e->ptr_name, "unknown dummy, read or write mode");
+		for (j = 0; j < i; j++) {
+			const struct SPI_NAND_FLASH_INFO_T *p = &spi_nand_flash_tables[j];
+
+			if (p->mfr_id == e->mfr_id && p->dev_id == e->dev_id &&
+			    (!p->dev_id_2 || p->dev_id_2 == e->dev_id_2)) {
+				if (p->device_size != e->device_size || p->page_size != e->page_size ||
+				    p->erase_size != e->erase_size || p->oob_size != e->oob_size)
+					bad(t, i, e->ptr_name, "unreachable, an earlier entry with another geometry matches the same id");
+				break;
+			}
+		}
+	}
+}
+
+#ifdef EEPROM_SUPPORT
+/* A name lookup takes the first entry containing the given name, so a later
+ * entry whose name is part of an earlier one can never be selected */
+#define CHECK_EEPROM_LIST(list, size_field, extra)					\
+	do {										\
+		size_t n = sizeof(list) / sizeof(list[0]), i, j;			\
+		if (!n || list[n - 1].size_field)					\
+			bad(#list, n, NULL, "missing the zero-size terminator");	\
+		for (i = 0; i + 1 < n; i++) {						\
+			if (!list[i].name || !list[i].size_field) {			\
+				bad(#list, i, list[i].name, "terminator before the end"); \
+				continue;						\
+			}								\
+			if (!pow2(list[i].size_field))					\
+				bad(#list, i, list[i].name, "size not a power of two");	\
+			extra;								\
+			for (j = 0; j < i; j++)						\
+				if (list[j].name && strstr(list[j].name, list[i].name))	\
+					bad(#list, i, list[i].name, "unreachable by name"); \
+		}									\
+	} while (0)
+
+static void check_eeprom(void)
+{
+	CHECK_EEPROM_LIST(eepromlist, size,
+		if (!eepromlist[i].page_size || eepromlist[i].size % eepromlist[i].page_size ||
+		    eepromlist[i].addr_size < 1 || eepromlist[i].addr_size > 2)
+			bad("eepromlist", i, eepromlist[i].name, "bad page or address size"));
+	CHECK_EEPROM_LIST(seepromlist, total_bytes,
+		if (seepromlist[i].total_bytes != 1UL << seepromlist[i].addr_bits)
+			bad("seepromlist", i, seepromlist[i].name, "address bits do not span the size"));
+	CHECK_EEPROM_LIST(mw_eepromlist, size, (void)0);
+}
+#endif
+
+/*
+ * Find a multiplier that puts every key in its own slot of a 1 << bits
+ * table, growing the table until one turns up
+ */
+static int chipdb_perfect_hash(const u32 *keys, int n, u32 *mult, int *bits)
+{
+	static unsigned char used[1 << CHIPDB_MAX_BITS];
+	u32 x = 0x9e3779b9;
+	int b, tries, i;
+
+	for (b = 1; (1 << b) < 2 * n; b++)
+		;
+	for (; b <= CHIPDB_MAX_BITS; b++) {
+		for (tries = 0; tries < 100000; tries++) {
+			x ^= x << 13;
+			x ^= x >> 17;
+			x ^= x << 5;
+			memset(used, 0, 1 << b);
+			for (i = 0; i < n; i++) {
+				u32 h = chipdb_hash(keys[i], x | 1, b);
+
+				if (used[h])
+					break;
+				used[h] = 1;
+			}
+			if (i == n) {
+				*mult = x | 1;
+				*bits = b;
+				return 0;
+			}
+		}
+	}
+	return -1;
+}
+
+/*
+ * Group the entries by key in table order and write the slot table;
+ * order[] lists the entry indexes group after group
+ */
+static int emit_index(const char *path, const char *name, const char *prefix,
+		      const char *source, const u32 *entry_keys, int n, int with_order)
+{
+	u32 *keys = calloc(n, sizeof(*keys));
+	int *order = calloc(n, sizeof(*order));
+	struct chipdb_slot *slots = NULL;
+	int n_keys = 0, n_order = 0, bits, i, j, k;
+	u32 mult;
+	FILE *f;
+
+	if (!keys || !order)
+		return -1;
+	for (i = 0; i < n; i++) {
+		for (k = 0; k < n_keys && keys[k] != entry_keys[i]; k++)
+			;
+		if (k == n_keys)
+			keys[n_keys++] = entry_keys[i];
+	}
+	if (chipdb_perfect_hash(keys, n_keys, &mult, &bits)) {
+		fprintf(stderr, "chipdb: %s: no collision-free hash for %d keys\n", path, n_keys);
+		return -1;
+	}
+	slots = calloc(1 << bits, sizeof(*slots));
+	if (!slots)
+		return -1;
+	for (k = 0; k < n_keys; k++) {
+		struct chipdb_slot *s = &slots[chipdb_hash(keys[k], mult, bits)];
+
+		s->key = keys[k];
+		for (j = 0; j < n; j++) {
+			if (entry_keys[j] != keys[k])
+				continue;
+			if (!with_order && s->count && j != s->first + s->count) {
+				fprintf(stderr, "chipdb: %s: key %08x is not contiguous\n", path, keys[k]);
+				return -1;
+			}
+			if (!s->count)
+				s->first = with_order ? n_order : j;
+			order[n_order++] = j;
+			s->count++;
+		}
+	}
+
+	f = fopen(path, "w");
+	if (!f) {
+		perror(path);
+		return -1;
+	}
+	fprintf(f, "/* Generated by chipdb_gen from %s, do not edit */\n", source);
+	fprintf(f, "#ifndef __%s_H__\n#define __%s_H__\n\n", prefix, prefix);
+	fprintf(f, "#define %s_ENTRIES %d\n", prefix, n);
+	fprintf(f, "#define %s_MULT 0x%08xu\n", prefix, mult);
+	fprintf(f, "#define %s_BITS %d\n\n", prefix, bits);
+	fprintf(f, "static const struct chipdb_slot %s_slots[1 << %s_BITS] = {\n", name, prefix);
+	for (i = 0; i < (1 << bits); i++)
+		if (slots[i].count)
+			fprintf(f, "\t[%d] = { 0x%08x, %u, %u },\n", i, slots[i].key,
+				slots[i].first, slots[i].count);
+	fprintf(f, "};\n");
+	if (with_order) {
+		fprintf(f, "\nstatic const u16 %s_order[%d] = {", name, n);
+		for (i = 0; i < n_order; i++)
+			fprintf(f, "%s%d,", i % 16 ? " " : "\n\t", order[i]);
+		fprintf(f, "\n};\n");
+	}
+	fprintf(f, "\n#endif /* __%s_H__ */\n", prefix);
+	if (ferror(f) | fclose(f)) {
+		perror(path);
+		remove(path);
+		return -1;
+	}
+	free(slots);
+	free(order);
+	free(keys);
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	size_t n_nor = get_spi_nor_flash_table_size();
+	size_t n_nand = get_spi_nand_flash_table_size();
+	u32 *keys;
+	size_t i;
+
+	if (argc != 3) {
+		fprintf(stderr, "Usage: %s <snor_index.h> <snand_index.h>\n", argv[0]);
+		return 2;
+	}
+
+	check_nor();
+	check_nand();
+#ifdef EEPROM_SUPPORT
+	check_eeprom();
+#endif
+	if (errors) {
+		fprintf(stderr, "chipdb: %d bad table %s\n", errors, errors == 1 ? "entry" : "entries");
+		return 1;
+	}
+
+	keys = calloc(n_nor > n_nand ? n_nor : n_nand, sizeof(*keys));
+	if (!keys)
+		return 1;
+	for (i = 0; i < n_nor; i++)
+		keys[i] = CHIPDB_NOR_KEY(chips_data[i].id, chips_data[i].jedec_id);
+	if (emit_index(argv[1], "snor_index", "SNOR_INDEX", "spi_nor_flash_tables.c",
+		       keys, n_nor, 0))
+		return 1;
+	for (i = 0; i < n_nand; i++)
+		keys[i] = CHIPDB_NAND_KEY(spi_nand_flash_tables[i].mfr_id, spi_nand_flash_tables[i].dev_id);
+	if (emit_index(argv[2], "snand_index", "SNAND_INDEX", "spi_nand_flash_tables.c",
+		       keys, n_nand, 1))
+		return 1;
+	free(keys);
+
+	printf("chipdb: %zu NOR, %zu NAND entries indexed\n", n_nor, n_nand);
+	return 0;
+}
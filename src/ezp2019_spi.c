@@ -9,9 +9,14 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
+#include <time.h>
 #include "ezp2019_spi.h"
 #include <libusb-1.0/libusb.h>
 
+#ifndef LIBUSB_CALL
+#define LIBUSB_CALL
+#endif
+
 /* SPI NAND opcodes (from spi_nand_flash_defs.h) */
 #define _SPI_NAND_OP_READ_ID             0x9F
 #define _SPI_NAND_OP_READ_ID_2           0x90
@@ -71,8 +76,83 @@ static uint32_t ezp_write_next_addr = 0;
 static uint8_t ezp_cmd_buf[EZP_CMD_BUF_SIZE];
 static uint32_t ezp_cmd_len = 0;
 
+/* Status poll back-off: the first sleep, doubled up to the caller's cap */
+#define EZP_POLL_MIN_US 1000
+
+/* Command round trips (OUT sent to response in), per command ID */
+struct ezp_latency {
+	unsigned long count;
+	double total_ms;
+	double max_ms;
+};
+static struct ezp_latency ezp_latency[256];
+
+#ifndef __EMSCRIPTEN__
+/* Response transfer, submitted before its command goes out */
+static struct libusb_transfer *ezp_in_transfer = NULL;
+
+/* Read session: after TRIGGER the device streams from the start address,
+ * pulled in through a ring of queued IN transfers. Each transfer is a
+ * multiple of EZP2019_READ_SIZE, the device's page. */
+#define EZP_READ_URBS     8
+#define EZP_READ_URB_SIZE (16 * EZP2019_READ_SIZE)
+
+struct ezp_read_slot {
+	struct libusb_transfer *transfer;
+	uint8_t buf[EZP_READ_URB_SIZE];
+	int done;
+	bool active;
+};
+static struct ezp_read_slot ezp_read_ring[EZP_READ_URBS];
+static unsigned int ezp_read_head = 0;     /* slot holding the next byte */
+static uint32_t ezp_read_offset = 0;       /* next byte within that slot */
+static bool ezp_read_session = false;
+static uint32_t ezp_read_next_addr = 0;    /* address of the next byte */
+static uint32_t ezp_read_submit_addr = 0;  /* address the next slot queued will start at */
+
+static void ezp_end_read_session(void);
+#endif
+
 /* ------------------------------------------------------------------ */
 
+static double ezp_now_ms(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+static void ezp_latency_report(void)
+{
+	unsigned int i;
+
+	if (!debug_enabled)
+		return;
+	for (i = 0; i < 256; i++) {
+		if (!ezp_latency[i].count)
+			continue;
+		fprintf(stderr, "[DEBUG] EZP: cmd 0x%02x: %lu round trips, avg %.2f ms, max %.2f ms\n",
+			i, ezp_latency[i].count, ezp_latency[i].total_ms / ezp_latency[i].count,
+			ezp_latency[i].max_ms);
+	}
+	memset(ezp_latency, 0, sizeof(ezp_latency));
+}
+
+#ifndef __EMSCRIPTEN__
+static void LIBUSB_CALL ezp_cb_in(struct libusb_transfer *transfer)
+{
+	*(int *)transfer->user_data = 1;
+}
+
+static void ezp_wait_transfer(int *done)
+{
+	while (!*done) {
+		if (libusb_handle_events_timeout_completed(NULL, &(struct timeval){1, 0}, done) < 0)
+			break;
+	}
+}
+#endif
+
 static void prepare_command_packet(uint8_t packet[EZP2019_PACKET_SIZE],
 				    uint8_t command_id,
 				    uint32_t size,
@@ -108,29 +188,74 @@ static int ezp_send_raw_command(const uint8_t command[EZP2019_PACKET_SIZE],
 				 uint8_t result[EZP2019_PACKET_SIZE])
 {
 	int sent = 0, received = 0, ret;
+	double t0, dt;
 
 	if (ezp_handle == NULL)
 		return -1;
 
 	EZP_DEBUG("ezp_send_raw_command: cmd_id=0x%02x\n", command[1]);
 
+#ifndef __EMSCRIPTEN__
+	/* Responses come in on the data endpoint, stop the read-ahead first */
+	ezp_end_read_session();
+#endif
+	t0 = ezp_now_ms();
+#ifndef __EMSCRIPTEN__
+	/* The response is taken the moment it arrives: its IN transfer is
+	 * already pending when the command goes out, bounded by the USB
+	 * timeout instead of a fixed sleep. */
+	int done = 0;
+	if (result) {
+		if (ezp_in_transfer == NULL)
+			ezp_in_transfer = libusb_alloc_transfer(0);
+		if (ezp_in_transfer == NULL)
+			return -1;
+		libusb_fill_bulk_transfer(ezp_in_transfer, ezp_handle, EZP_EP_IN,
+					  result, EZP2019_PACKET_SIZE, ezp_cb_in, &done,
+					  EZP2019_USB_TIMEOUT);
+		ret = libusb_submit_transfer(ezp_in_transfer);
+		if (ret) {
+			fprintf(stderr, "EZP: failed to submit response transfer: %s\n", libusb_error_name(ret));
+			return -1;
+		}
+	}
+#endif
+
 	ret = libusb_bulk_transfer(ezp_handle, EZP_EP_CMD_OUT,
 				    (unsigned char *)command, EZP2019_PACKET_SIZE,
 				    &sent, EZP2019_USB_TIMEOUT);
 	if (ret || sent != EZP2019_PACKET_SIZE) {
 		fprintf(stderr, "EZP: failed to send command: %s\n", libusb_error_name(ret));
+#ifndef __EMSCRIPTEN__
+		if (result) {
+			libusb_cancel_transfer(ezp_in_transfer);
+			ezp_wait_transfer(&done);
+		}
+#endif
 		return -1;
 	}
 
 	if (result) {
-		usleep(50000);
+#ifndef __EMSCRIPTEN__
+		ezp_wait_transfer(&done);
+		ret = ezp_in_transfer->status == LIBUSB_TRANSFER_COMPLETED ? 0 : LIBUSB_ERROR_IO;
+		if (ezp_in_transfer->status == LIBUSB_TRANSFER_TIMED_OUT)
+			ret = LIBUSB_ERROR_TIMEOUT;
+		received = ezp_in_transfer->actual_length;
+#else
 		ret = libusb_bulk_transfer(ezp_handle, EZP_EP_IN,
 					    result, EZP2019_PACKET_SIZE,
 					    &received, EZP2019_USB_TIMEOUT);
+#endif
 		if (ret || received != EZP2019_PACKET_SIZE) {
 			fprintf(stderr, "EZP: failed to read response: %s\n", libusb_error_name(ret));
 			return -1;
 		}
+		dt = ezp_now_ms() - t0;
+		ezp_latency[command[1]].count++;
+		ezp_latency[command[1]].total_ms += dt;
+		if (dt > ezp_latency[command[1]].max_ms)
+			ezp_latency[command[1]].max_ms = dt;
 		trace_dump("EZP RESPONSE", result, EZP2019_PACKET_SIZE);
 	}
 
@@ -186,11 +311,17 @@ static int ezp_do_connect(void)
 	return 0;
 }
 
+/* Poll until the programmer reports idle. The budget is max_retries polls
+ * at sleep_us apiece; the sleeps themselves start at EZP_POLL_MIN_US and
+ * double up to sleep_us, so short operations are not charged a full
+ * interval. */
 static int ezp_poll_status(int max_retries, int sleep_us, const char *label)
 {
 	uint8_t spacket[EZP2019_PACKET_SIZE];
 	uint8_t sresult[EZP2019_PACKET_SIZE];
 	int total_polls = 0;
+	int delay_us = min(EZP_POLL_MIN_US, sleep_us);
+	double deadline = ezp_now_ms() + (double)max_retries * sleep_us / 1000.0;
 	int ret;
 
 	EZP_DEBUG("ezp_poll_status: polling (max %d retries, %d us) for %s\n",
@@ -199,9 +330,10 @@ static int ezp_poll_status(int max_retries, int sleep_us, const char *label)
 	memset(spacket, 0, EZP2019_PACKET_SIZE);
 	spacket[1] = EZP_CMD_STATUS;
 
-	while (max_retries-- > 0) {
+	while (ezp_now_ms() < deadline) {
 		total_polls++;
-		usleep(sleep_us);
+		usleep(delay_us);
+		delay_us = min(delay_us * 2, sleep_us);
 		memset(sresult, 0xFF, sizeof(sresult));
 		ret = ezp_send_raw_command(spacket, sresult);
 		if (ret == 0) {
@@ -229,30 +361,21 @@ static int ezp_wait_ready(void)
 static void ezp_finalize_write_session(void)
 {
 	if (ezp_write_session) {
-		usleep(100000);
 		ezp_wait_ready();
 		ezp_write_session = false;
 	}
 }
 
-static int ezp_do_read(uint32_t addr, uint32_t len, uint8_t *buf)
+/* Send the READ_SPI setup and the TRIGGER that starts the data stream at
+ * addr; the device then streams from there until the end of the chip. */
+static int ezp_start_read(uint32_t addr)
 {
 	uint8_t packet[EZP2019_PACKET_SIZE];
 	uint8_t result[EZP2019_PACKET_SIZE];
-	uint8_t chunk_buf[EZP2019_READ_SIZE];
-	int ret;
-
-	EZP_DEBUG("ezp_do_read: addr=0x%08x len=%u\n", addr, len);
-
-	/* Finalize any pending write stream before reading */
-	ezp_finalize_write_session();
 
 	/* Ensure chip is configured */
-	if (!ezp_chip_configured) {
-		ret = ezp_do_connect();
-		if (ret < 0)
-			return -1;
-	}
+	if (!ezp_chip_configured && ezp_do_connect() < 0)
+		return -1;
 
 	/* Send READ_SPI setup */
 	memset(packet, 0, EZP2019_PACKET_SIZE);
@@ -260,8 +383,7 @@ static int ezp_do_read(uint32_t addr, uint32_t len, uint8_t *buf)
 				ezp_chip_size, ezp_chip_pagesize,
 				ezp_chip_protocol, ezp_chip_timeout,
 				ezp_chip_id);
-	ret = ezp_send_raw_command(packet, result);
-	if (ret < 0)
+	if (ezp_send_raw_command(packet, result) < 0)
 		return -1;
 
 	/* Send trigger transfer with address */
@@ -271,8 +393,123 @@ static int ezp_do_read(uint32_t addr, uint32_t len, uint8_t *buf)
 	packet[9]  = (addr >> 16) & 0xFF;
 	packet[10] = (addr >> 8) & 0xFF;
 	packet[11] = addr & 0xFF;
-	ret = ezp_send_raw_command(packet, result);
-	if (ret < 0)
+	return ezp_send_raw_command(packet, result);
+}
+
+#ifndef __EMSCRIPTEN__
+static void ezp_read_submit(struct ezp_read_slot *slot)
+{
+	if (ezp_chip_size && ezp_read_submit_addr >= ezp_chip_size)
+		return;
+	if (slot->transfer == NULL)
+		slot->transfer = libusb_alloc_transfer(0);
+	if (slot->transfer == NULL)
+		return;
+	libusb_fill_bulk_transfer(slot->transfer, ezp_handle, EZP_EP_IN,
+				  slot->buf, EZP_READ_URB_SIZE, ezp_cb_in, &slot->done,
+				  EZP2019_USB_TIMEOUT);
+	slot->done = 0;
+	if (libusb_submit_transfer(slot->transfer) == 0) {
+		slot->active = true;
+		ezp_read_submit_addr += EZP_READ_URB_SIZE;
+	}
+}
+
+/* Cancel the read-ahead and drop whatever it already fetched */
+static void ezp_end_read_session(void)
+{
+	unsigned int i;
+
+	if (!ezp_read_session)
+		return;
+	for (i = 0; i < EZP_READ_URBS; i++) {
+		if (!ezp_read_ring[i].active)
+			continue;
+		libusb_cancel_transfer(ezp_read_ring[i].transfer);
+		ezp_wait_transfer(&ezp_read_ring[i].done);
+		ezp_read_ring[i].active = false;
+	}
+	ezp_read_session = false;
+}
+
+/* Reads at the address where the previous one stopped are served from the
+ * open session: the ring of IN transfers stays queued between calls, so
+ * the device keeps streaming while the caller handles the previous chunk. */
+static int ezp_do_read(uint32_t addr, uint32_t len, uint8_t *buf)
+{
+	uint8_t *out = buf;
+	uint32_t remaining = len;
+	unsigned int i;
+
+	EZP_DEBUG("ezp_do_read: addr=0x%08x len=%u session=%d next=0x%08x\n",
+		addr, len, ezp_read_session, ezp_read_next_addr);
+
+	/* Finalize any pending write stream before reading */
+	ezp_finalize_write_session();
+
+	if (!ezp_read_session || addr != ezp_read_next_addr) {
+		ezp_end_read_session();
+		if (ezp_start_read(addr) < 0)
+			return -1;
+		ezp_read_session = true;
+		ezp_read_head = 0;
+		ezp_read_offset = 0;
+		ezp_read_submit_addr = addr;
+		for (i = 0; i < EZP_READ_URBS; i++)
+			ezp_read_submit(&ezp_read_ring[i]);
+	}
+
+	while (remaining > 0) {
+		struct ezp_read_slot *slot = &ezp_read_ring[ezp_read_head];
+		uint32_t avail, n;
+
+		if (!slot->active) {
+			fprintf(stderr, "EZP: read past end of stream at 0x%08x\n", addr + (len - remaining));
+			ezp_end_read_session();
+			return -1;
+		}
+		ezp_wait_transfer(&slot->done);
+		if (slot->transfer->status != LIBUSB_TRANSFER_COMPLETED ||
+		    (uint32_t)slot->transfer->actual_length <= ezp_read_offset) {
+			fprintf(stderr, "EZP: read error at offset %u: status %d (got %d bytes)\n",
+				len - remaining, slot->transfer->status, slot->transfer->actual_length);
+			slot->active = false;
+			ezp_end_read_session();
+			return -1;
+		}
+
+		avail = slot->transfer->actual_length - ezp_read_offset;
+		n = min(avail, remaining);
+		memcpy(out, slot->buf + ezp_read_offset, n);
+		out += n;
+		remaining -= n;
+		ezp_read_offset += n;
+
+		/* Slot drained: requeue it at the tail of the ring */
+		if (ezp_read_offset == (uint32_t)slot->transfer->actual_length) {
+			slot->active = false;
+			ezp_read_offset = 0;
+			ezp_read_head = (ezp_read_head + 1) % EZP_READ_URBS;
+			ezp_read_submit(slot);
+		}
+	}
+	ezp_read_next_addr = addr + len;
+
+	trace_dump("EZP READ DATA", buf, len);
+	return 0;
+}
+#else
+static int ezp_do_read(uint32_t addr, uint32_t len, uint8_t *buf)
+{
+	uint8_t chunk_buf[EZP2019_READ_SIZE];
+	int ret;
+
+	EZP_DEBUG("ezp_do_read: addr=0x%08x len=%u\n", addr, len);
+
+	/* Finalize any pending write stream before reading */
+	ezp_finalize_write_session();
+
+	if (ezp_start_read(addr) < 0)
 		return -1;
 
 	/* Read data from the device in EZP2019_READ_SIZE chunks.
@@ -316,6 +553,7 @@ static int ezp_do_read(uint32_t addr, uint32_t len, uint8_t *buf)
 	trace_dump("EZP READ DATA", buf, len);
 	return 0;
 }
+#endif
 
 static int ezp_do_write(uint32_t addr, uint32_t len, const uint8_t *data)
 {
@@ -410,7 +648,6 @@ static int ezp_do_erase(void)
 
 	/* Wait for completion with longer timeout for chip erase.
 	 * Chip erase on a 16 MB flash can take 30-60 seconds. */
-	usleep(5000);
 	ret = ezp_poll_status(12000, 5000, "erase");
 	if (ret < 0)
 		return -1;
@@ -563,7 +800,9 @@ int ezp2019_spi_send_command(unsigned int writecnt, unsigned int readcnt,
 			if (readcnt >= 2) readarr[1] = (ezp_chip_id >> 8) & 0xFF;
 			trace_dump("SPI READ (READ_ID)", readarr, readcnt);
 		} else if (opcode == OPCODE_RDSR || opcode == 0x35 || opcode == 0x15) {
-			/* Read Status Register - return not-busy */
+			/* Read Status Register - the device polls the chip itself, so
+			 * once a pending write stream is finalized it is not busy */
+			ezp_finalize_write_session();
 			memset(readarr, 0, readcnt);
 			EZP_DEBUG("ezp: RDSR (0x%02x) returning 0x00\n", opcode);
 			trace_dump("SPI READ (RDSR)", readarr, readcnt);
@@ -623,7 +862,21 @@ int ezp2019_spi_shutdown(void)
 	ezp_finalize_write_session();
 
 	ezp_reset_device();
+	ezp_latency_report();
 
+#ifndef __EMSCRIPTEN__
+	if (ezp_in_transfer) {
+		libusb_free_transfer(ezp_in_transfer);
+		ezp_in_transfer = NULL;
+	}
+	unsigned int i;
+	for (i = 0; i < EZP_READ_URBS; i++) {
+		if (ezp_read_ring[i].transfer) {
+			libusb_free_transfer(ezp_read_ring[i].transfer);
+			ezp_read_ring[i].transfer = NULL;
+		}
+	}
+#endif
 	libusb_release_interface(ezp_handle, 0);
 	libusb_close(ezp_handle);
 	libusb_exit(NULL);
@@ -751,6 +1004,57 @@ int ezp2019_spi_init(void)
 static int ezp_cs_select(void)   { return ezp_enable_pins(true); }
 static int ezp_cs_deselect(void) { return ezp_enable_pins(false); }
 
+/* ------------------------------------------------------------------ */
+/* Native operations: the NOR layer hands over whole ranges instead of
+ * raw SPI, so nothing has to be reconstructed from ezp_cmd_buf. */
+
+/* Largest single DATA_OUT transfer, keeps each one well inside
+ * EZP2019_USB_TIMEOUT */
+#define EZP_WRITE_CHUNK 4096
+
+static int ezp_read_range(unsigned long addr, unsigned long len, unsigned char *buf)
+{
+	if (ezp_handle == NULL)
+		return -1;
+	ezp_cmd_len = 0;
+	if (ezp_do_read(addr, len, buf) < 0)
+		return -1;
+	return 0;
+}
+
+static int ezp_program_page(unsigned long addr, unsigned long len, const unsigned char *buf)
+{
+	if (ezp_handle == NULL)
+		return -1;
+	ezp_cmd_len = 0;
+	/* Consecutive calls keep the write session open; it is finalized
+	 * by the next status read, read, erase or shutdown. */
+	while (len > 0) {
+		uint32_t chunk = min(len, EZP_WRITE_CHUNK);
+		if (ezp_do_write(addr, chunk, buf) < 0)
+			return -1;
+		addr += chunk;
+		buf += chunk;
+		len -= chunk;
+	}
+	return 0;
+}
+
+static int ezp_erase_block(unsigned long addr, unsigned long len)
+{
+	if (ezp_handle == NULL)
+		return -1;
+	ezp_cmd_len = 0;
+	/* A partial range would wipe data outside it */
+	if (addr != 0 || len != ezp_chip_size) {
+		fprintf(stderr, "EZP: erases the whole chip only, erase of 0x%lx bytes at 0x%08lx refused\n",
+			len, addr);
+		return -1;
+	}
+	fprintf(stderr, "[EZP] Chip erase\n");
+	return ezp_do_erase();
+}
+
 const struct spi_programmer ezp2019_programmer = {
 	.name           = "EZP2019",
 	.init           = ezp2019_spi_init,
@@ -759,4 +1063,7 @@ const struct spi_programmer ezp2019_programmer = {
 	.cs_select      = ezp_cs_select,
 	.cs_deselect    = ezp_cs_deselect,
 	.libusb_version = get_libusb_version,
+	.read_range     = ezp_read_range,
+	.program_page   = ezp_program_page,
+	.erase_block    = ezp_erase_block,
 };
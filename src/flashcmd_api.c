@@ -32,6 +32,8 @@ long flash_cmd_init(struct flash_cmd *cmd)
 			cmd->flash_erase = snor_erase;
 			cmd->flash_write = snor_write;
 			cmd->flash_read = snor_read;
+			cmd->flash_update = snor_update;
+			cmd->flash_write_verify = snor_write_verify;
 		}
 		else if ((flen = snand_init()) > 0)
 		{
@@ -19,6 +19,11 @@ struct flash_cmd
  	int (*flash_read)(unsigned char *buf, unsigned long from, unsigned long len);
  	int (*flash_erase)(unsigned long offs, unsigned long len);
  	int (*flash_write)(unsigned char *buf, unsigned long to, unsigned long len);
+ 	/* Optional: rewrite only what differs, verified; NULL if unsupported */
+ 	int (*flash_update)(unsigned char *buf, unsigned long to, unsigned long len);
+ 	/* Optional: write an erased range verifying each sector as it goes,
+ 	 * erasing and rewriting a bad sector when retry is set */
+ 	int (*flash_write_verify)(unsigned char *buf, unsigned long to, unsigned long len, int retry);
 };
 
 long flash_cmd_init(struct flash_cmd *cmd);
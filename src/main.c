@@ -69,11 +69,12 @@ static int do_verify(const unsigned char *expected, unsigned long addr, unsigned
 
 void usage(const char *program_name)
 {
-	char use[1024];
+	char use[2048];
 	snprintf(use, sizeof(use), "Usage: %s [options]\n"
 				   "Automation:\n"
 				   "  -R <file>    Read chip (read twice and compare)\n"
 				   "  -W <file>    Write chip (erase + write + verify)\n"
+				   "  -U <file>    Update chip (rewrite changed sectors only + verify, SPI NOR)\n"
 				   "\n"
 				   "Single operations:\n"
 				   "  -i           Read chip ID\n"
@@ -91,6 +92,7 @@ void usage(const char *program_name)
 				   "  -o <bytes>   Set OOB size\n"
 				   "  -I           Ignore ECC errors\n"
 				   "  -k           Skip BAD pages\n"
+				   "  --cont-read  Stream reads in continuous-read mode if the chip has it\n"
 				   "\n"
 				   "EEPROM:\n"
 				   "  -E <chip>    Select EEPROM type\n"
@@ -104,7 +106,8 @@ void usage(const char *program_name)
 				   "  -P <prog>    Programmer type: ch341a, ezp2019, auto (default: auto)\n"
 				   "  -V, --version  Show version and exit\n"
 			   "  --debug      Enable debug messages for USB communication\n"
-				   "  --trace      Dump SPI commands and data (implies --debug)\n",
+				   "  --trace      Dump SPI commands and data (implies --debug)\n"
+				   "  --calibrate  Measure and cache CH341A USB transfer settings\n",
 		 program_name);
 	printf("%s", use);
 	exit(0);
@@ -125,12 +128,14 @@ int main(int argc, char *argv[])
 	static struct option long_options[] = {
 		{"debug", no_argument, NULL, 0},
 		{"trace", no_argument, NULL, 0},
+		{"calibrate", no_argument, NULL, 0},
+		{"cont-read", no_argument, NULL, 0},
 		{"version", no_argument, NULL, 'V'},
 		{0, 0, 0, 0}
 	};
 	int option_index = 0;
 
-	while ((c = getopt_long(argc, argv, "diIhveLkl:a:w:r:W:R:o:s:E:f:8P:V", long_options, &option_index)) != -1)
+	while ((c = getopt_long(argc, argv, "diIhveLkl:a:w:r:W:U:R:o:s:E:f:8P:V", long_options, &option_index)) != -1)
 	{
 		if (c == 0)
 		{
@@ -149,6 +154,16 @@ int main(int argc, char *argv[])
 				printf("Trace mode enabled (debug forced on)\n");
 				continue;
 			}
+			if (strcmp(lname, "calibrate") == 0)
+			{
+				ch341a_spi_force_calibration();
+				continue;
+			}
+			if (strcmp(lname, "cont-read") == 0)
+			{
+				Cont_read = 1;
+				continue;
+			}
 		}
 		switch (c)
 		{
@@ -246,6 +261,7 @@ int main(int argc, char *argv[])
 		case 'r':
 		case 'w':
 		case 'W':
+		case 'U':
 		case 'R':
 			if (!op)
 			{
@@ -436,6 +452,25 @@ if (op == 'W')
 
  		if (len == flen)
  			len = wlen;
+
+ 		/* Where the flash can, each sector is verified as it is written
+ 		 * and the separate full read-back is skipped */
+ 		if (prog.flash_write_verify)
+ 		{
+ 			printf("Write + verify addr = 0x%08llX, len = 0x%08llX\n", addr, len);
+ 			ret = prog.flash_write_verify(buf, addr, len, 1);
+ 			fclose(fp);
+ 			free(buf);
+ 			if (ret <= 0)
+ 			{
+ 				printf("Write Status: BAD(%d)\n", ret);
+ 				goto out;
+ 			}
+ 			printf("Write Status: OK\n");
+ 			printf("\nStep 3/3 - VERIFY: done per sector during write\n");
+ 			printf("Verify Status: OK\n");
+ 			goto okout;
+ 		}
  		printf("Write addr = 0x%08llX, len = 0x%08llX\n", addr, len);
  		ret = prog.flash_write(buf, addr, len);
  		if (ret <= 0)
@@ -462,6 +497,55 @@ if (op == 'W')
   		goto okout;
  	}
 
+	if (op == 'U')
+	{
+		printf("UPDATE (Write changed sectors + Verify):\n");
+		if (!prog.flash_update)
+		{
+			fprintf(stderr, "Incremental update is supported for SPI NOR only, use -W\n");
+			goto out;
+		}
+		if (addr && !len)
+			len = flen - addr;
+		else if (!addr && !len)
+			len = flen;
+		buf = (unsigned char *)malloc(len);
+		if (!buf)
+		{
+			fprintf(stderr, "Malloc failed for program buffer: len=%lld.\n", len);
+			goto out;
+		}
+		fp = fopen(op_arg, "rb");
+		if (!fp)
+		{
+			fprintf(stderr, "Couldn't open file %s for reading.\n", op_arg);
+			free(buf);
+			goto out;
+		}
+		wlen = fread(buf, 1, len, fp);
+		if (ferror(fp))
+		{
+			fprintf(stderr, "Error reading file [%s]\n", op_arg);
+			fclose(fp);
+			free(buf);
+			goto out;
+		}
+		fclose(fp);
+
+		if (len == flen)
+			len = wlen;
+		printf("Update addr = 0x%08llX, len = 0x%08llX\n", addr, len);
+		ret = prog.flash_update(buf, addr, len);
+		free(buf);
+		if (ret < 0)
+		{
+			printf("Update Status: BAD(%d)\n", ret);
+			goto out;
+		}
+		printf("Update Status: OK\n");
+		goto okout;
+	}
+
 if (op == 'R')
  	{
  		printf("READ (Read twice and compare):\n");
@@ -601,8 +685,16 @@ if (op == 'R')
 		if (len == flen)
 			len = wlen;
 		printf("Write addr = 0x%08llX, len = 0x%08llX\n", addr, len);
-		ret = prog.flash_write(buf, addr, len);
-		if (ret > 0)
+		if (vr && prog.flash_write_verify)
+		{
+			/* -w doesn't erase, so a bad sector is only reported */
+			ret = prog.flash_write_verify(buf, addr, len, 0);
+			if (ret > 0)
+				printf("Status: OK, verified per sector\n");
+			else
+				printf("Status: BAD(%d)\n", ret);
+		}
+		else if ((ret = prog.flash_write(buf, addr, len)) > 0)
 		{
 			printf("Status: OK\n");
 			if (vr)
@@ -18,6 +18,7 @@ extern int ECC_fcheck;
 extern int ECC_ignore;
 extern u32 OOB_size;
 extern int Skip_BAD_page;
+extern int Cont_read;
 extern unsigned char _ondie_ecc_flag;
 
 #endif /* __NANDCMD_API_H__ */
@@ -9,6 +9,8 @@
 int snor_read(unsigned char *buf, unsigned long from, unsigned long len);
 int snor_erase(unsigned long offs, unsigned long len);
 int snor_write(unsigned char *buf, unsigned long to, unsigned long len);
+int snor_update(unsigned char *buf, unsigned long to, unsigned long len);
+int snor_write_verify(unsigned char *buf, unsigned long to, unsigned long len, int retry);
 long snor_init(void);
 void support_snor_list(void);
 
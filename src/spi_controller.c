@@ -4,6 +4,7 @@
  */
 
 #include <stdio.h>
+#include <string.h>
 #include "ch341a_spi.h"
 #include "ezp2019_spi.h"
 #include "spi_controller.h"
@@ -15,6 +16,38 @@ extern const struct spi_programmer ezp2019_programmer;
 static const struct spi_programmer *active = NULL;
 static int active_type = PROGRAMMER_AUTO;
 
+extern int debug_enabled;
+
+/* Deferred write-only transactions, see SPI_CONTROLLER_Queue_Begin() */
+#define SPI_CONTROLLER_QUEUE_CMDS  32
+#define SPI_CONTROLLER_QUEUE_BYTES 8192
+
+static struct {
+	unsigned int depth;
+	unsigned int count;
+	unsigned int used;
+	unsigned int lens[SPI_CONTROLLER_QUEUE_CMDS];
+	u8 buf[SPI_CONTROLLER_QUEUE_BYTES];
+	unsigned long queued;
+	unsigned long flushes;
+	SPI_CONTROLLER_RTN_T error;
+} queue;
+
+/* Dual-output reads stay on trial until a check against a single-bit read
+ * of the same bytes either passes on data that exercises both lines or fails.
+ * Blank probe windows prove nothing; after SPI_CONTROLLER_DUAL_TRIES of them
+ * dual reads are given up for the session. */
+#define SPI_CONTROLLER_DUAL_PROBE 64
+#define SPI_CONTROLLER_DUAL_TRIES 8
+#define SPI_CONTROLLER_DUAL_CMD 16
+
+static enum {
+	DUAL_UNTESTED = 0,
+	DUAL_OK,
+	DUAL_OFF
+} dual_state;
+static unsigned int dual_tries;
+
 int spi_controller_init(int type)
 {
 	if (type == PROGRAMMER_EZP2019) {
@@ -50,8 +83,16 @@ int spi_controller_init(int type)
 
 void spi_controller_shutdown(void)
 {
-	if (active)
+	if (active) {
+		SPI_CONTROLLER_Flush();
+		if (debug_enabled && queue.flushes)
+			fprintf(stderr, "[DEBUG] spi_controller: %lu commands in %lu batches, %lu round trips saved\n",
+				queue.queued, queue.flushes, queue.queued - queue.flushes);
 		active->shutdown();
+	}
+	memset(&queue, 0, sizeof(queue));
+	dual_state = DUAL_UNTESTED;
+	dual_tries = 0;
 	active = NULL;
 	active_type = PROGRAMMER_AUTO;
 }
@@ -71,6 +112,11 @@ const char *spi_controller_libusb_version(void)
 	return active ? active->libusb_version() : "unknown";
 }
 
+int spi_controller_native_erase(void)
+{
+	return active && active->erase_block;
+}
+
 SPI_CONTROLLER_RTN_T SPI_CONTROLLER_Enable_Manual_Mode(void)
 {
 	return SPI_CONTROLLER_RTN_NO_ERROR;
@@ -78,21 +124,25 @@ SPI_CONTROLLER_RTN_T SPI_CONTROLLER_Enable_Manual_Mode(void)
 
 SPI_CONTROLLER_RTN_T SPI_CONTROLLER_Write_One_Byte(u8 data)
 {
+	SPI_CONTROLLER_Flush();
 	return (SPI_CONTROLLER_RTN_T)active->send_command(1, 0, &data, NULL);
 }
 
 SPI_CONTROLLER_RTN_T SPI_CONTROLLER_Chip_Select_High(void)
 {
+	SPI_CONTROLLER_Flush();
 	return (SPI_CONTROLLER_RTN_T)active->cs_deselect();
 }
 
 SPI_CONTROLLER_RTN_T SPI_CONTROLLER_Chip_Select_Low(void)
 {
+	SPI_CONTROLLER_Flush();
 	return (SPI_CONTROLLER_RTN_T)active->cs_select();
 }
 
 SPI_CONTROLLER_RTN_T SPI_CONTROLLER_Read_NByte(u8 *ptr_rtn_data, u32 len)
 {
+	SPI_CONTROLLER_Flush();
 #ifdef __EMSCRIPTEN__
 	/* Split large reads into 4096-byte chunks for WASM USB stack */
 	u32 offset = 0;
@@ -111,6 +161,7 @@ SPI_CONTROLLER_RTN_T SPI_CONTROLLER_Read_NByte(u8 *ptr_rtn_data, u32 len)
 
 SPI_CONTROLLER_RTN_T SPI_CONTROLLER_Write_NByte(u8 *ptr_data, u32 len)
 {
+	SPI_CONTROLLER_Flush();
 #ifdef __EMSCRIPTEN__
 	/* Split large writes into 4096-byte chunks for WASM USB stack */
 	u32 offset = 0;
@@ -126,3 +177,224 @@ SPI_CONTROLLER_RTN_T SPI_CONTROLLER_Write_NByte(u8 *ptr_data, u32 len)
 	return (SPI_CONTROLLER_RTN_T)active->send_command(len, 0, ptr_data, NULL);
 #endif
 }
+
+SPI_CONTROLLER_RTN_T SPI_CONTROLLER_Transaction(const u8 *ptr_write, u32 write_len,
+						u8 *ptr_read, u32 read_len)
+{
+	SPI_CONTROLLER_RTN_T ret = SPI_CONTROLLER_RTN_NO_ERROR;
+
+	if (queue.depth && active->transaction_batch && write_len && !read_len) {
+		if (write_len <= SPI_CONTROLLER_QUEUE_BYTES) {
+			if (queue.count == SPI_CONTROLLER_QUEUE_CMDS ||
+			    queue.used + write_len > SPI_CONTROLLER_QUEUE_BYTES)
+				ret = SPI_CONTROLLER_Flush();
+			memcpy(queue.buf + queue.used, ptr_write, write_len);
+			queue.lens[queue.count++] = write_len;
+			queue.used += write_len;
+			return ret;
+		}
+	}
+	ret = SPI_CONTROLLER_Flush();
+	if (ret)
+		return ret;
+
+	if (active->transaction)
+		return (SPI_CONTROLLER_RTN_T)active->transaction(write_len, read_len, ptr_write, ptr_read);
+
+	/* Generic fallback: same sequence the callers used to issue by hand */
+	SPI_CONTROLLER_Chip_Select_Low();
+	if (write_len)
+		ret = SPI_CONTROLLER_Write_NByte((u8 *)ptr_write, write_len);
+	if (ret == SPI_CONTROLLER_RTN_NO_ERROR && read_len)
+		ret = SPI_CONTROLLER_Read_NByte(ptr_read, read_len);
+	SPI_CONTROLLER_Chip_Select_High();
+	return ret;
+}
+
+/* Samples fetched per transaction_repeat call; the ready check runs between
+ * calls, so this bounds how far a poll overshoots the ready sample. */
+#define SPI_CONTROLLER_POLL_RUN 16
+
+SPI_CONTROLLER_RTN_T SPI_CONTROLLER_Poll_Status(const u8 *cmd, u32 cmd_len, u8 busy_mask, u32 count,
+						u8 *status, u32 *ready_idx)
+{
+	SPI_CONTROLLER_RTN_T ret;
+	u8 samples[SPI_CONTROLLER_POLL_RUN];
+	u32 done = 0;
+	u32 i;
+
+	*ready_idx = count;
+	ret = SPI_CONTROLLER_Flush();
+	if (ret)
+		return ret;
+
+	while (done < count) {
+		u32 n = count - done;
+
+		if (active->transaction_repeat) {
+			if (n > SPI_CONTROLLER_POLL_RUN)
+				n = SPI_CONTROLLER_POLL_RUN;
+			if (active->transaction_repeat(n, cmd_len, 1, cmd, samples))
+				return SPI_CONTROLLER_RTN_READ_DATAPFIFO_ERROR;
+		} else {
+			n = 1;
+			ret = SPI_CONTROLLER_Transaction(cmd, cmd_len, samples, 1);
+			if (ret)
+				return ret;
+		}
+		for (i = 0; i < n; i++) {
+			*status = samples[i];
+			if (!(samples[i] & busy_mask)) {
+				*ready_idx = done + i;
+				return SPI_CONTROLLER_RTN_NO_ERROR;
+			}
+		}
+		done += n;
+	}
+	return SPI_CONTROLLER_RTN_NO_ERROR;
+}
+
+/* Check dual-output reads on the first bytes cmd addresses: read them both
+ * ways and compare. Leaves dual_state DUAL_OK, DUAL_OFF, or DUAL_UNTESTED
+ * when the bytes were all 0x00/0xFF, which a stuck line matches too. */
+static SPI_CONTROLLER_RTN_T spi_controller_dual_probe(const u8 *cmd, u32 cmd_len, u8 single_op, u32 len)
+{
+	SPI_CONTROLLER_RTN_T ret;
+	u8 ref_cmd[SPI_CONTROLLER_DUAL_CMD];
+	u8 ref[SPI_CONTROLLER_DUAL_PROBE], dual[SPI_CONTROLLER_DUAL_PROBE];
+	u32 n = len < SPI_CONTROLLER_DUAL_PROBE ? len : SPI_CONTROLLER_DUAL_PROBE;
+	u32 i;
+
+	memcpy(ref_cmd, cmd, cmd_len);
+	ref_cmd[0] = single_op;
+	ret = SPI_CONTROLLER_Transaction(ref_cmd, cmd_len, ref, n);
+	if (ret)
+		return ret;
+	if (active->read_dual(cmd_len, n, cmd, dual))
+		return SPI_CONTROLLER_RTN_READ_DATAPFIFO_ERROR;
+	if (memcmp(ref, dual, n)) {
+		dual_state = DUAL_OFF;
+		if (debug_enabled)
+			fprintf(stderr, "[DEBUG] spi_controller: dual-output read mismatch, using single-bit reads\n");
+		return SPI_CONTROLLER_RTN_NO_ERROR;
+	}
+	for (i = 0; i < n; i++) {
+		if (ref[i] != 0x00 && ref[i] != 0xFF) {
+			dual_state = DUAL_OK;
+			if (debug_enabled)
+				fprintf(stderr, "[DEBUG] spi_controller: dual-output reads verified\n");
+			return SPI_CONTROLLER_RTN_NO_ERROR;
+		}
+	}
+	if (++dual_tries >= SPI_CONTROLLER_DUAL_TRIES) {
+		dual_state = DUAL_OFF;
+		if (debug_enabled)
+			fprintf(stderr, "[DEBUG] spi_controller: no data to verify dual-output reads on, using single-bit reads\n");
+	}
+	return SPI_CONTROLLER_RTN_NO_ERROR;
+}
+
+SPI_CONTROLLER_RTN_T SPI_CONTROLLER_Read_Dual(const u8 *cmd, u32 cmd_len, u8 single_op, u8 *buf, u32 len)
+{
+	SPI_CONTROLLER_RTN_T ret;
+
+	if (!active->read_dual || dual_state == DUAL_OFF || cmd_len > SPI_CONTROLLER_DUAL_CMD)
+		return SPI_CONTROLLER_RTN_NOT_SUPPORTED;
+	ret = SPI_CONTROLLER_Flush();
+	if (ret)
+		return ret;
+	/* Unverified dual data is never handed back: until a probe passes the
+	 * caller reads single-bit */
+	if (dual_state != DUAL_OK) {
+		ret = spi_controller_dual_probe(cmd, cmd_len, single_op, len);
+		if (ret)
+			return ret;
+		if (dual_state != DUAL_OK)
+			return SPI_CONTROLLER_RTN_NOT_SUPPORTED;
+	}
+	if (active->read_dual(cmd_len, len, cmd, buf))
+		return SPI_CONTROLLER_RTN_READ_DATAPFIFO_ERROR;
+	return SPI_CONTROLLER_RTN_NO_ERROR;
+}
+
+void SPI_CONTROLLER_Queue_Begin(void)
+{
+	queue.depth++;
+}
+
+SPI_CONTROLLER_RTN_T SPI_CONTROLLER_Queue_End(void)
+{
+	SPI_CONTROLLER_RTN_T ret;
+
+	if (queue.depth && --queue.depth)
+		return SPI_CONTROLLER_RTN_NO_ERROR;
+	ret = SPI_CONTROLLER_Flush();
+	if (ret == SPI_CONTROLLER_RTN_NO_ERROR)
+		ret = queue.error;
+	queue.error = SPI_CONTROLLER_RTN_NO_ERROR;
+	return ret;
+}
+
+/* Send whatever is queued. A batch failure is also remembered and reported
+ * by the outermost Queue_End, since the commands that filled it have
+ * already returned. */
+SPI_CONTROLLER_RTN_T SPI_CONTROLLER_Flush(void)
+{
+	int ret;
+
+	if (!queue.count || !active)
+		return SPI_CONTROLLER_RTN_NO_ERROR;
+	if (debug_enabled)
+		fprintf(stderr, "[DEBUG] spi_controller: flushing %u queued commands (%u bytes)\n",
+			queue.count, queue.used);
+	ret = active->transaction_batch(queue.count, queue.lens, queue.buf);
+	queue.queued += queue.count;
+	queue.flushes++;
+	queue.count = 0;
+	queue.used = 0;
+	if (ret) {
+		queue.error = SPI_CONTROLLER_RTN_WRITE_DATAPFIFO_ERROR;
+		return SPI_CONTROLLER_RTN_WRITE_DATAPFIFO_ERROR;
+	}
+	return SPI_CONTROLLER_RTN_NO_ERROR;
+}
+
+SPI_CONTROLLER_RTN_T SPI_CONTROLLER_Read_Range(u32 addr, u8 *buf, u32 len)
+{
+	if (!active->read_range)
+		return SPI_CONTROLLER_RTN_NOT_SUPPORTED;
+	SPI_CONTROLLER_Flush();
+	if (active->read_range(addr, len, buf))
+		return SPI_CONTROLLER_RTN_READ_DATAPFIFO_ERROR;
+	return SPI_CONTROLLER_RTN_NO_ERROR;
+}
+
+SPI_CONTROLLER_RTN_T SPI_CONTROLLER_Program_Page(u32 addr, const u8 *buf, u32 len)
+{
+	if (!active->program_page)
+		return SPI_CONTROLLER_RTN_NOT_SUPPORTED;
+	SPI_CONTROLLER_Flush();
+	if (active->program_page(addr, len, buf))
+		return SPI_CONTROLLER_RTN_WRITE_DATAPFIFO_ERROR;
+	return SPI_CONTROLLER_RTN_NO_ERROR;
+}
+
+SPI_CONTROLLER_RTN_T SPI_CONTROLLER_Erase_Block(u32 addr, u32 len)
+{
+	if (!active->erase_block)
+		return SPI_CONTROLLER_RTN_NOT_SUPPORTED;
+	SPI_CONTROLLER_Flush();
+	if (active->erase_block(addr, len))
+		return SPI_CONTROLLER_RTN_WRITE_DATAPFIFO_ERROR;
+	return SPI_CONTROLLER_RTN_NO_ERROR;
+}
+
+SPI_CONTROLLER_RTN_T SPI_CONTROLLER_Read_Status(u8 *status)
+{
+	if (!active->read_status)
+		return SPI_CONTROLLER_RTN_NOT_SUPPORTED;
+	SPI_CONTROLLER_Flush();
+	if (active->read_status(status))
+		return SPI_CONTROLLER_RTN_READ_DATAPFIFO_ERROR;
+	return SPI_CONTROLLER_RTN_NO_ERROR;
+}
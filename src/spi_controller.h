@@ -27,6 +27,7 @@ typedef enum {
 	SPI_CONTROLLER_RTN_SET_OPFIFO_ERROR,
 	SPI_CONTROLLER_RTN_READ_DATAPFIFO_ERROR,
 	SPI_CONTROLLER_RTN_WRITE_DATAPFIFO_ERROR,
+	SPI_CONTROLLER_RTN_NOT_SUPPORTED,
 	SPI_CONTROLLER_RTN_DEF_NO
 } SPI_CONTROLLER_RTN_T;
 
@@ -41,6 +42,33 @@ struct spi_programmer {
 	int (*cs_select)(void);   /* CS low — select flash */
 	int (*cs_deselect)(void); /* CS high — deselect flash */
 	const char *(*libusb_version)(void);
+	/* Optional: CS low, write writecnt bytes, read readcnt bytes, CS high,
+	 * issued as one unit. NULL falls back to cs_select/send_command/cs_deselect. */
+	int (*transaction)(unsigned int writecnt, unsigned int readcnt,
+			   const unsigned char *writearr,
+			   unsigned char *readarr);
+	/* Optional: issue count write-only transactions back to back, each with
+	 * its own CS frame. writearr holds the commands concatenated, lengths in
+	 * writecnts. NULL disables write combining for this programmer. */
+	int (*transaction_batch)(unsigned int count, const unsigned int *writecnts,
+				 const unsigned char *writearr);
+	/* Optional: issue the same short command count times back to back, each
+	 * with its own CS frame, storing readcnt bytes per repetition in readarr.
+	 * NULL makes status polling issue one transaction per sample. */
+	int (*transaction_repeat)(unsigned int count, unsigned int writecnt, unsigned int readcnt,
+				  const unsigned char *writearr, unsigned char *readarr);
+	/* Optional: CS-framed read with the command clocked single-bit and the
+	 * data phase on two lines, for dual-output opcodes such as 0x3B. NULL
+	 * keeps all reads single-bit. */
+	int (*read_dual)(unsigned int writecnt, unsigned int readcnt,
+			 const unsigned char *writearr, unsigned char *readarr);
+	/* Optional native flash operations on linear NOR addresses, for
+	 * programmers that run reads, writes and erases themselves rather than
+	 * as raw SPI. NULL makes the flash layer fall back to raw commands. */
+	int (*read_range)(unsigned long addr, unsigned long len, unsigned char *buf);
+	int (*program_page)(unsigned long addr, unsigned long len, const unsigned char *buf);
+	int (*erase_block)(unsigned long addr, unsigned long len);
+	int (*read_status)(unsigned char *status);
 };
 
 /* Init: pass PROGRAMMER_AUTO, PROGRAMMER_CH341A, or PROGRAMMER_EZP2019.
@@ -50,6 +78,7 @@ void spi_controller_shutdown(void);
 const char *spi_controller_name(void);
 const char *spi_controller_libusb_version(void);
 int spi_controller_type(void);  /* Returns PROGRAMMER_CH341A, _EZP2019, or _AUTO */
+int spi_controller_native_erase(void);  /* Erases go through the programmer's own erase_block */
 
 /* Thin wrappers — dispatch through the active vtable */
 SPI_CONTROLLER_RTN_T SPI_CONTROLLER_Enable_Manual_Mode(void);
@@ -59,4 +88,40 @@ SPI_CONTROLLER_RTN_T SPI_CONTROLLER_Read_NByte(u8 *ptr_rtn_data, u32 len);
 SPI_CONTROLLER_RTN_T SPI_CONTROLLER_Chip_Select_Low(void);
 SPI_CONTROLLER_RTN_T SPI_CONTROLLER_Chip_Select_High(void);
 
+/* Complete CS-framed command: select, write ptr_write, read into ptr_read,
+ * deselect. Either segment may be empty. */
+SPI_CONTROLLER_RTN_T SPI_CONTROLLER_Transaction(const u8 *ptr_write, u32 write_len,
+						u8 *ptr_read, u32 read_len);
+
+/* Write combining: between Queue_Begin and Queue_End, write-only transactions
+ * are deferred and sent as one batch when the queue fills, a read needs the
+ * bus, or the outermost Queue_End is reached. Calls nest. */
+void SPI_CONTROLLER_Queue_Begin(void);
+SPI_CONTROLLER_RTN_T SPI_CONTROLLER_Queue_End(void);
+SPI_CONTROLLER_RTN_T SPI_CONTROLLER_Flush(void);
+
+/* Read a one-byte status register up to count times with command cmd,
+ * stopping at the first sample with none of busy_mask set. *ready_idx gets
+ * that sample's index, or count if the device stayed busy; *status gets the
+ * ready sample, or the last one read. Programmers with a transaction_repeat
+ * hook take a whole run of samples per USB round trip. */
+SPI_CONTROLLER_RTN_T SPI_CONTROLLER_Poll_Status(const u8 *cmd, u32 cmd_len, u8 busy_mask, u32 count,
+						u8 *status, u32 *ready_idx);
+
+/* Dual-output read: cmd carries a dual-output opcode with its address and
+ * dummy bytes; single_op is the single-bit opcode taking the same layout.
+ * Until the first bytes of a read with informative data have matched a
+ * single_op read, nothing is read dual: a mismatch (e.g. a board that doesn't
+ * wire the second data line), or too many blank probes, turns dual reads off
+ * for the session. Returns SPI_CONTROLLER_RTN_NOT_SUPPORTED whenever the
+ * caller must read single-bit instead. */
+SPI_CONTROLLER_RTN_T SPI_CONTROLLER_Read_Dual(const u8 *cmd, u32 cmd_len, u8 single_op, u8 *buf, u32 len);
+
+/* Native flash operations. Return SPI_CONTROLLER_RTN_NOT_SUPPORTED when the
+ * active programmer has no such hook; the caller then uses raw SPI. */
+SPI_CONTROLLER_RTN_T SPI_CONTROLLER_Read_Range(u32 addr, u8 *buf, u32 len);
+SPI_CONTROLLER_RTN_T SPI_CONTROLLER_Program_Page(u32 addr, const u8 *buf, u32 len);
+SPI_CONTROLLER_RTN_T SPI_CONTROLLER_Erase_Block(u32 addr, u32 len);
+SPI_CONTROLLER_RTN_T SPI_CONTROLLER_Read_Status(u8 *status);
+
 #endif /* __SPI_CONTROLLER_H__ */
@@ -19,163 +19,111 @@ struct spi_eeprom seeprom_info;
 int seepromsize = 0;
 int spage_size = 0;
 
+// RDSR samples taken per poll, one USB round trip on CH341A
+#define SEEP_POLL_SAMPLES 8
+
 // Returns 0 on success, -1 on SPI error
 static int wait_ready(void)
 {
-	uint8_t data[1];
-	SPI_CONTROLLER_RTN_T spi_ret;
+	uint8_t cmd = SEEP_RDSR_CMD;
+	uint8_t sr;
+	u32 idx;
 
 	while (1)
 	{
-		SPI_CONTROLLER_Chip_Select_Low();
-		spi_ret = SPI_CONTROLLER_Write_One_Byte(SEEP_RDSR_CMD);
-		if (spi_ret != SPI_CONTROLLER_RTN_NO_ERROR)
-			goto spi_fail;
-		spi_ret = SPI_CONTROLLER_Read_NByte(data, 1); // Removed speed argument
-		SPI_CONTROLLER_Chip_Select_High();
-		if (spi_ret != SPI_CONTROLLER_RTN_NO_ERROR)
-			return -1; // Check read error after CS high
-
-		if ((data[0] & 0x01) == 0)
+		if (SPI_CONTROLLER_Poll_Status(&cmd, 1, 0x01, SEEP_POLL_SAMPLES, &sr, &idx) != SPI_CONTROLLER_RTN_NO_ERROR)
+			return -1;
+
+		if (idx < SEEP_POLL_SAMPLES)
 			break;
 		usleep(1);
 	}
 	return 0;
-spi_fail:
-	SPI_CONTROLLER_Chip_Select_High();
-	return -1;
 }
 
 // Returns 0 on success, -1 on SPI error
 static int write_enable(void)
 {
+	uint8_t wren = SEEP_WREN_CMD;
+	uint8_t rdsr = SEEP_RDSR_CMD;
 	uint8_t data[1];
-	SPI_CONTROLLER_RTN_T spi_ret;
 
 	while (1)
 	{
-		SPI_CONTROLLER_Chip_Select_Low();
-		spi_ret = SPI_CONTROLLER_Write_One_Byte(SEEP_WREN_CMD);
-		SPI_CONTROLLER_Chip_Select_High();
-		if (spi_ret != SPI_CONTROLLER_RTN_NO_ERROR)
-			return -1; // Check write error after CS high
+		if (SPI_CONTROLLER_Transaction(&wren, 1, NULL, 0) != SPI_CONTROLLER_RTN_NO_ERROR)
+			return -1;
 		usleep(1);
 
-		SPI_CONTROLLER_Chip_Select_Low();
-		spi_ret = SPI_CONTROLLER_Write_One_Byte(SEEP_RDSR_CMD);
-		if (spi_ret != SPI_CONTROLLER_RTN_NO_ERROR)
-			goto spi_fail;
-		spi_ret = SPI_CONTROLLER_Read_NByte(data, 1); // Removed speed argument
-		SPI_CONTROLLER_Chip_Select_High();
-		if (spi_ret != SPI_CONTROLLER_RTN_NO_ERROR)
-			return -1; // Check read error after CS high
+		if (SPI_CONTROLLER_Transaction(&rdsr, 1, data, 1) != SPI_CONTROLLER_RTN_NO_ERROR)
+			return -1;
 
 		if (data[0] == 0x02)
 			break;
 		usleep(1);
 	}
 	return 0;
-spi_fail:
-	SPI_CONTROLLER_Chip_Select_High();
-	return -1;
 }
 
-// Returns 0 on success, -1 on SPI error
-static int eeprom_write_byte(struct spi_eeprom *dev, uint32_t address, uint8_t data)
+// Fills opcode and address bytes, returns the header length
+static int eeprom_fill_cmd(struct spi_eeprom *dev, uint8_t *buf, uint8_t cmd, uint32_t address)
 {
-	uint8_t buf[5];
-	SPI_CONTROLLER_RTN_T spi_ret;
-	int ret = 0;
-
-	if (write_enable() != 0)
-		return -1;
-
-	buf[0] = SEEP_WRITE_CMD;
+	buf[0] = cmd;
 	if (dev->addr_bits == 9 && address > 0xFF)
 		buf[0] = buf[0] | 0x08;
 
-	SPI_CONTROLLER_Chip_Select_Low();
 	if (dev->addr_bits > 16)
 	{
 		buf[1] = (address & 0xFF0000) >> 16;
 		buf[2] = (address & 0xFF00) >> 8;
 		buf[3] = (address & 0xFF);
-		buf[4] = data;
-		spi_ret = SPI_CONTROLLER_Write_NByte(buf, 5); // Removed speed argument
+		return 4;
 	}
 	else if (dev->addr_bits < 10)
 	{
 		buf[1] = (address & 0xFF);
-		buf[2] = data;
-		spi_ret = SPI_CONTROLLER_Write_NByte(buf, 3); // Removed speed argument
+		return 2;
 	}
-	else
-	{
-		buf[1] = (address & 0xFF00) >> 8;
-		buf[2] = (address & 0xFF);
-		buf[3] = data;
-		spi_ret = SPI_CONTROLLER_Write_NByte(buf, 4); // Removed speed argument
-	}
-	SPI_CONTROLLER_Chip_Select_High();
+	buf[1] = (address & 0xFF00) >> 8;
+	buf[2] = (address & 0xFF);
+	return 3;
+}
+
+// Returns 0 on success, -1 on SPI error
+static int eeprom_write_byte(struct spi_eeprom *dev, uint32_t address, uint8_t data)
+{
+	uint8_t buf[5];
+	int offs;
 
-	if (spi_ret != SPI_CONTROLLER_RTN_NO_ERROR)
-		ret = -1; // Check write error after CS high
+	if (write_enable() != 0)
+		return -1;
 
-	if (ret == 0 && wait_ready() != 0)
-		ret = -1; // Check wait_ready error
+	offs = eeprom_fill_cmd(dev, buf, SEEP_WRITE_CMD, address);
+	buf[offs] = data;
+
+	if (SPI_CONTROLLER_Transaction(buf, offs + 1, NULL, 0) != SPI_CONTROLLER_RTN_NO_ERROR)
+		return -1;
 
-	return ret;
+	return wait_ready() != 0 ? -1 : 0;
 }
 
 // Returns 0 on success, -1 on SPI error
 static int eeprom_write_page(struct spi_eeprom *dev, uint32_t address, int page_size, uint8_t *data)
 {
 	uint8_t buf[MAX_SEEP_PSIZE];
-	uint8_t offs = 0;
-	SPI_CONTROLLER_RTN_T spi_ret;
-	int ret = 0;
+	int offs;
 
 	memset(buf, 0, sizeof(buf));
 
-	buf[0] = SEEP_WRITE_CMD;
-	if (dev->addr_bits == 9 && address > 0xFF)
-		buf[0] = buf[0] | 0x08;
-
-	if (dev->addr_bits > 16)
-	{
-		buf[1] = (address & 0xFF0000) >> 16;
-		buf[2] = (address & 0xFF00) >> 8;
-		buf[3] = (address & 0xFF);
-		offs = 4;
-	}
-	else if (dev->addr_bits < 10)
-	{
-		buf[1] = (address & 0xFF);
-		offs = 2;
-	}
-	else
-	{
-		buf[1] = (address & 0xFF00) >> 8;
-		buf[2] = (address & 0xFF);
-		offs = 3;
-	}
-
+	offs = eeprom_fill_cmd(dev, buf, SEEP_WRITE_CMD, address);
 	memcpy(&buf[offs], data, page_size);
 
 	if (write_enable() != 0)
 		return -1;
 
-	SPI_CONTROLLER_Chip_Select_Low();
-	spi_ret = SPI_CONTROLLER_Write_NByte(buf, offs + page_size); // Removed speed argument
-	SPI_CONTROLLER_Chip_Select_High();
-
-	if (spi_ret != SPI_CONTROLLER_RTN_NO_ERROR)
-		ret = -1; // Check write error after CS high
-
-	if (ret == 0 && wait_ready() != 0)
-		ret = -1; // Check wait_ready error
+	if (SPI_CONTROLLER_Transaction(buf, offs + page_size, NULL, 0) != SPI_CONTROLLER_RTN_NO_ERROR)
+		return -1;
 
-	return ret;
+	return wait_ready() != 0 ? -1 : 0;
 }
 
 // Returns byte read on success, or -1 on SPI error (casting to uint8_t truncates)
@@ -183,56 +131,14 @@ static int eeprom_write_page(struct spi_eeprom *dev, uint32_t address, int page_
 static int eeprom_read_byte(struct spi_eeprom *dev, uint32_t address)
 {
 	uint8_t buf[4];
-	uint8_t data = 0xFF; // Default to 0xFF in case of error?
-	SPI_CONTROLLER_RTN_T spi_ret;
-	buf[0] = SEEP_READ_CMD;
+	uint8_t data;
+	int offs;
 
-	if (dev->addr_bits == 9 && address > 0xFF)
-		buf[0] = buf[0] | 0x08;
+	offs = eeprom_fill_cmd(dev, buf, SEEP_READ_CMD, address);
+	if (SPI_CONTROLLER_Transaction(buf, offs, &data, 1) != SPI_CONTROLLER_RTN_NO_ERROR)
+		return -1; // Indicate error
 
-	SPI_CONTROLLER_Chip_Select_Low();
-	if (dev->addr_bits > 16)
-	{
-		buf[1] = (address & 0xFF0000) >> 16;
-		buf[2] = (address & 0xFF00) >> 8;
-		buf[3] = (address & 0xFF);
-		spi_ret = SPI_CONTROLLER_Write_NByte(buf, 4); // Removed speed argument
-		if (spi_ret != SPI_CONTROLLER_RTN_NO_ERROR)
-			goto spi_fail;
-		spi_ret = SPI_CONTROLLER_Read_NByte(buf, 1); // Removed speed argument
-		if (spi_ret != SPI_CONTROLLER_RTN_NO_ERROR)
-			goto spi_fail;
-		data = buf[0];
-	}
-	else if (dev->addr_bits < 10)
-	{
-		buf[1] = (address & 0xFF);
-		spi_ret = SPI_CONTROLLER_Write_NByte(buf, 2); // Removed speed argument
-		if (spi_ret != SPI_CONTROLLER_RTN_NO_ERROR)
-			goto spi_fail;
-		spi_ret = SPI_CONTROLLER_Read_NByte(buf, 1); // Removed speed argument
-		if (spi_ret != SPI_CONTROLLER_RTN_NO_ERROR)
-			goto spi_fail;
-		data = buf[0];
-	}
-	else
-	{
-		buf[1] = (address & 0xFF00) >> 8;
-		buf[2] = (address & 0xFF);
-		spi_ret = SPI_CONTROLLER_Write_NByte(buf, 3); // Removed speed argument
-		if (spi_ret != SPI_CONTROLLER_RTN_NO_ERROR)
-			goto spi_fail;
-		spi_ret = SPI_CONTROLLER_Read_NByte(buf, 1); // Removed speed argument
-		if (spi_ret != SPI_CONTROLLER_RTN_NO_ERROR)
-			goto spi_fail;
-		data = buf[0];
-	}
-	SPI_CONTROLLER_Chip_Select_High();
 	return (int)data; // Return byte value (0-255)
-
-spi_fail:
-	SPI_CONTROLLER_Chip_Select_High();
-	return -1; // Indicate error
 }
 
 int32_t parseSEEPsize(char *seepromname, struct spi_eeprom *seeprom)
@@ -29,11 +29,14 @@
 #include "nandcmd_api.h"
 #include "timer.h"
 #include "spi_nand_flash_defs.h"
+#include "chipdb.h"
+#include "snand_index.h"
 
 int ECC_fcheck = 1;
 int ECC_ignore = 0;
 u32 OOB_size = 0;
 int Skip_BAD_page = 0;
+int Cont_read = 0;
 
 unsigned char _plane_select_bit = 0;
 static unsigned char _die_id = 0;
@@ -204,7 +207,6 @@ static const ecc_check_table_entry *spi_nand_find_ecc_entry(u8 mfr_id, u16 dev_i
 }
 
 static u8 _current_cache_page[_SPI_NAND_CACHE_SIZE];
-static u8 _current_cache_page_data[_SPI_NAND_PAGE_SIZE];
 static u8 _current_cache_page_oob[_SPI_NAND_OOB_SIZE];
 static u8 _current_cache_page_oob_mapping[_SPI_NAND_OOB_SIZE];
 
@@ -301,10 +303,7 @@ static SPI_NAND_FLASH_RTN_T spi_nand_load_page_into_cache(u32 page_number)
 		spi_nand_protocol_page_read(page_number);
 
 		// Check status for load page/erase/program complete
-		do
-		{
-			spi_nand_protocol_get_status_reg_3(&status);
-		} while (status & _SPI_NAND_VAL_OIP);
+		spi_nand_protocol_wait_ready(&status);
 
 		_SPI_NAND_DEBUG_PRINTF(SPI_NAND_FLASH_DEBUG_LEVEL_1,
 				       "spi_nand_load_page_into_cache: status = 0x%x\n", status);
@@ -352,17 +351,14 @@ SPI_NAND_FLASH_RTN_T spi_nand_erase_block(u32 block_index)
 
 	spi_nand_select_die((block_index << _SPI_NAND_BLOCK_ROW_ADDRESS_OFFSET));
 
-	/* 2.2 Enable write_to flash */
+	/* 2.2 Enable write_to flash, 2.3 Erasing one block (one USB batch) */
+	_SPI_NAND_QUEUE_BEGIN();
 	spi_nand_protocol_write_enable();
-
-	/* 2.3 Erasing one block */
 	spi_nand_protocol_block_erase(block_index);
+	_SPI_NAND_QUEUE_END();
 
 	/* 2.4 Checking status for erase complete */
-	do
-	{
-		spi_nand_protocol_get_status_reg_3(&status);
-	} while (status & _SPI_NAND_VAL_OIP);
+	spi_nand_protocol_wait_ready(&status);
 
 	/* 2.5 Disable write_flash */
 	spi_nand_protocol_write_disable();
@@ -429,10 +425,14 @@ static SPI_NAND_FLASH_RTN_T spi_nand_erase_internal(u32 addr, u32 len)
 	return (rtn_status);
 }
 
-static SPI_NAND_FLASH_RTN_T spi_nand_read_page(u32 page_number, SPI_NAND_FLASH_READ_SPEED_MODE_T speed_mode)
+/* Copy the page in the chip's cache into ptr_buf, or into the host page
+ * cache when ptr_buf is NULL. The OOB is read along with the data, so
+ * ptr_buf needs room for it behind the page; it is kept in the OOB buffers
+ * either way. */
+static void spi_nand_read_cache(u32 page_number, u8 *ptr_buf, SPI_NAND_FLASH_READ_SPEED_MODE_T speed_mode)
 {
 	struct SPI_NAND_FLASH_INFO_T *ptr_dev_info_t;
-	SPI_NAND_FLASH_RTN_T rtn_status = SPI_NAND_FLASH_RTN_NO_ERROR;
+	u8 *ptr_dst;
 	u16 read_addr;
 
 	ptr_dev_info_t = _SPI_NAND_GET_DEVICE_INFO_PTR;
@@ -440,6 +440,51 @@ static SPI_NAND_FLASH_RTN_T spi_nand_read_page(u32 page_number, SPI_NAND_FLASH_R
 	/* read from read_addr index in the page */
 	read_addr = 0;
 
+	if (ptr_buf)
+		ptr_dst = ptr_buf;
+	else
+	{
+		ptr_dst = &_current_cache_page[0];
+		memset(_current_cache_page, 0x0, sizeof(_current_cache_page));
+
+		_SPI_NAND_DEBUG_PRINTF(SPI_NAND_FLASH_DEBUG_LEVEL_2, "spi_nand_read_page: before read, _current_cache_page:\n");
+		_SPI_NAND_DEBUG_PRINTF_ARRAY(SPI_NAND_FLASH_DEBUG_LEVEL_2, &_current_cache_page[0], _SPI_NAND_CACHE_SIZE);
+	}
+
+	if (((ptr_dev_info_t->feature) & SPI_NAND_FLASH_PLANE_SELECT_HAVE))
+	{
+		_plane_select_bit = ((page_number >> 6) & (0x1));
+
+		_SPI_NAND_DEBUG_PRINTF(SPI_NAND_FLASH_DEBUG_LEVEL_1, "spi_nand_read_page: plane select = 0x%x\n", _plane_select_bit);
+	}
+
+	spi_nand_protocol_read_from_cache(read_addr, ((ptr_dev_info_t->page_size) + (ptr_dev_info_t->oob_size)), ptr_dst, speed_mode, ptr_dev_info_t->dummy_mode);
+
+	_SPI_NAND_DEBUG_PRINTF(SPI_NAND_FLASH_DEBUG_LEVEL_2, "spi_nand_read_page: after read, page 0x%x:\n", page_number);
+	_SPI_NAND_DEBUG_PRINTF_ARRAY(SPI_NAND_FLASH_DEBUG_LEVEL_2, ptr_dst, ((ptr_dev_info_t->page_size) + (ptr_dev_info_t->oob_size)));
+
+	/* Keep the oob segment aside */
+	if (ECC_fcheck)
+	{
+		memcpy(&_current_cache_page_oob[0], &ptr_dst[(ptr_dev_info_t->page_size)], (ptr_dev_info_t->oob_size));
+		memcpy(&_current_cache_page_oob_mapping[0], &_current_cache_page_oob[0], (ptr_dev_info_t->oob_size));
+	}
+
+	_SPI_NAND_DEBUG_PRINTF(SPI_NAND_FLASH_DEBUG_LEVEL_2, "spi_nand_read_page: _current_cache_page_oob:\n");
+	_SPI_NAND_DEBUG_PRINTF_ARRAY(SPI_NAND_FLASH_DEBUG_LEVEL_2, &_current_cache_page_oob[0], (ptr_dev_info_t->oob_size));
+	_SPI_NAND_DEBUG_PRINTF(SPI_NAND_FLASH_DEBUG_LEVEL_2, "spi_nand_read_page: _current_cache_page_oob_mapping:\n");
+	_SPI_NAND_DEBUG_PRINTF_ARRAY(SPI_NAND_FLASH_DEBUG_LEVEL_2, &_current_cache_page_oob_mapping[0], (ptr_dev_info_t->oob_size));
+
+	/* A page read straight into ptr_buf is not in the host page cache */
+	_current_page_num = ptr_buf ? 0xFFFFFFFF : page_number;
+}
+
+/* Read a page into ptr_buf (see spi_nand_read_cache()), or into the host page
+ * cache when ptr_buf is NULL. ptr_buf is only for pages not already cached. */
+static SPI_NAND_FLASH_RTN_T spi_nand_read_page(u32 page_number, u8 *ptr_buf, SPI_NAND_FLASH_READ_SPEED_MODE_T speed_mode)
+{
+	SPI_NAND_FLASH_RTN_T rtn_status = SPI_NAND_FLASH_RTN_NO_ERROR;
+
 	/* Switch to manual mode*/
 	_SPI_NAND_ENABLE_MANUAL_MODE();
 
@@ -457,57 +502,123 @@ static SPI_NAND_FLASH_RTN_T spi_nand_read_page(u32 page_number, SPI_NAND_FLASH_R
 
 	/* No matter what status, we must read the cache data to dram */
 	if ((_current_page_num != page_number))
-	{
-		memset(_current_cache_page, 0x0, sizeof(_current_cache_page));
+		spi_nand_read_cache(page_number, ptr_buf, speed_mode);
 
-		_SPI_NAND_DEBUG_PRINTF(SPI_NAND_FLASH_DEBUG_LEVEL_2, "spi_nand_read_page: before read, _current_cache_page:\n");
-		_SPI_NAND_DEBUG_PRINTF_ARRAY(SPI_NAND_FLASH_DEBUG_LEVEL_2, &_current_cache_page[0], _SPI_NAND_CACHE_SIZE);
+	return rtn_status;
+}
 
-		if (((ptr_dev_info_t->feature) & SPI_NAND_FLASH_PLANE_SELECT_HAVE))
-		{
-			_plane_select_bit = ((page_number >> 6) & (0x1));
+/* Sequential cache read: after a 0x13 for the first page, every 0x31 hands
+ * the loaded page over to the cache and starts loading the next one, so the
+ * array read of page n + 1 overlaps the transfer of page n. 0x3F hands over
+ * the last page. Runs are kept inside one block, so they never cross a die. */
+static void spi_nand_read_seq_begin(u32 page_number)
+{
+	u8 status;
 
-			_SPI_NAND_DEBUG_PRINTF(SPI_NAND_FLASH_DEBUG_LEVEL_1, "spi_nand_read_page: plane select = 0x%x\n", _plane_select_bit);
-		}
+	_SPI_NAND_DEBUG_PRINTF(SPI_NAND_FLASH_DEBUG_LEVEL_1, "spi_nand_read_seq_begin: page number = 0x%x\n", page_number);
 
-		{
-			spi_nand_protocol_read_from_cache(read_addr, ((ptr_dev_info_t->page_size) + (ptr_dev_info_t->oob_size)), &_current_cache_page[0], speed_mode, ptr_dev_info_t->dummy_mode);
-		}
+	_SPI_NAND_ENABLE_MANUAL_MODE();
+	spi_nand_select_die(page_number);
+	spi_nand_protocol_page_read(page_number);
+	spi_nand_protocol_wait_ready(&status);
+}
 
-		_SPI_NAND_DEBUG_PRINTF(SPI_NAND_FLASH_DEBUG_LEVEL_2, "spi_nand_read_page: after read, _current_cache_page:\n");
-		_SPI_NAND_DEBUG_PRINTF_ARRAY(SPI_NAND_FLASH_DEBUG_LEVEL_2, &_current_cache_page[0], _SPI_NAND_CACHE_SIZE);
+static SPI_NAND_FLASH_RTN_T spi_nand_read_page_seq(u32 page_number, bool last, u8 *ptr_buf, SPI_NAND_FLASH_READ_SPEED_MODE_T speed_mode)
+{
+	u8 status;
+	SPI_NAND_FLASH_RTN_T rtn_status;
 
-		/* Divide read page into data segment and oob segment  */
-		memcpy(&_current_cache_page_data[0], &_current_cache_page[0], (ptr_dev_info_t->page_size));
+	spi_nand_protocol_page_read_cache(last);
 
-		if (ECC_fcheck)
-		{
-			memcpy(&_current_cache_page_oob[0], &_current_cache_page[(ptr_dev_info_t->page_size)], (ptr_dev_info_t->oob_size));
-			memcpy(&_current_cache_page_oob_mapping[0], &_current_cache_page_oob[0], (ptr_dev_info_t->oob_size));
-		}
+	/* OIP only covers the hand-over, the next page keeps loading behind it */
+	spi_nand_protocol_wait_ready(&status);
 
-		_SPI_NAND_DEBUG_PRINTF(SPI_NAND_FLASH_DEBUG_LEVEL_2, "spi_nand_read_page: _current_cache_page:\n");
-		_SPI_NAND_DEBUG_PRINTF_ARRAY(SPI_NAND_FLASH_DEBUG_LEVEL_2, &_current_cache_page[0], ((ptr_dev_info_t->page_size) + (ptr_dev_info_t->oob_size)));
-		_SPI_NAND_DEBUG_PRINTF(SPI_NAND_FLASH_DEBUG_LEVEL_2, "spi_nand_read_page: _current_cache_page_oob:\n");
-		_SPI_NAND_DEBUG_PRINTF_ARRAY(SPI_NAND_FLASH_DEBUG_LEVEL_2, &_current_cache_page_oob[0], (ptr_dev_info_t->oob_size));
-		_SPI_NAND_DEBUG_PRINTF(SPI_NAND_FLASH_DEBUG_LEVEL_2, "spi_nand_read_page: _current_cache_page_oob_mapping:\n");
-		_SPI_NAND_DEBUG_PRINTF_ARRAY(SPI_NAND_FLASH_DEBUG_LEVEL_2, &_current_cache_page_oob_mapping[0], (ptr_dev_info_t->oob_size));
+	/* The ECC status now describes the page handed over */
+	rtn_status = (ECC_fcheck && !ECC_ignore) ? ecc_fail_check(page_number) : 0;
 
-		_current_page_num = page_number;
-	}
+	spi_nand_read_cache(page_number, ptr_buf, speed_mode);
 
 	return rtn_status;
 }
 
-static SPI_NAND_FLASH_RTN_T spi_nand_write_page(u32 page_number, u32 data_offset, u8 *ptr_data, u32 data_len, u32 oob_offset __attribute__((unused)), u8 *ptr_oob,
+/* Close a run left before its last page; the chip's cache then no longer
+ * holds _current_page_num */
+static void spi_nand_read_seq_abort(void)
+{
+	u8 status;
+
+	spi_nand_protocol_page_read_cache(true);
+	spi_nand_protocol_wait_ready(&status);
+	_current_page_num = 0xFFFFFFFF;
+}
+
+/* Continuous read: with BUF cleared the read-from-cache command after a
+ * 0x13 ignores its column address and streams page after page, OOB
+ * included, for as long as CS stays low. The chip only reports whether
+ * some page of the run was uncorrectable, not which one.
+ * The run is read single-bit: the controller checks an unproven dual read
+ * by reading the same bytes again in a new CS frame, and a continuous run
+ * can't be read twice. */
+static SPI_NAND_FLASH_RTN_T spi_nand_read_cont(u32 page_number, u32 page_count, u8 *ptr_rtn_buf)
+{
+	u8 feature, status;
+	struct SPI_NAND_FLASH_INFO_T *ptr_dev_info_t;
+	SPI_NAND_FLASH_RTN_T rtn_status = SPI_NAND_FLASH_RTN_NO_ERROR;
+
+	ptr_dev_info_t = _SPI_NAND_GET_DEVICE_INFO_PTR;
+
+	_SPI_NAND_DEBUG_PRINTF(SPI_NAND_FLASH_DEBUG_LEVEL_1, "spi_nand_read_cont: page number = 0x%x, count = 0x%x\n", page_number, page_count);
+
+	_SPI_NAND_ENABLE_MANUAL_MODE();
+	spi_nand_select_die(page_number);
+
+	spi_nand_protocol_get_status_reg_2(&feature);
+	spi_nand_protocol_set_status_reg_2(feature & ~_SPI_NAND_VAL_BUF);
+
+	spi_nand_protocol_page_read(page_number);
+	spi_nand_protocol_wait_ready(&status);
+
+	spi_nand_protocol_read_from_cache(0, page_count * ((ptr_dev_info_t->page_size) + (ptr_dev_info_t->oob_size)), ptr_rtn_buf, SPI_NAND_FLASH_READ_SPEED_MODE_SINGLE, ptr_dev_info_t->dummy_mode);
+
+	/* Raising CS ended the stream; 2 is one bad page, 3 several */
+	spi_nand_protocol_wait_ready(&status);
+	if (ECC_fcheck && !ECC_ignore &&
+	    ((status & _SPI_NAND_VAL_ECC_STATUS_MASK_30) >> _SPI_NAND_VAL_ECC_STATUS_SHIFT_4) >= _SPI_NAND_VAL_ECC_UNCORRECTABLE_2BIT)
+		rtn_status = SPI_NAND_FLASH_RTN_DETECTED_BAD_BLOCK;
+
+	spi_nand_protocol_set_status_reg_2(feature);
+	_current_page_num = 0xFFFFFFFF;
+
+	return rtn_status;
+}
+
+/* Load what spi_nand_write_page() programs into the chip's cache */
+static void spi_nand_write_page_load(bool full_page, u32 data_offset, u8 *ptr_data, u32 data_len,
+				     u32 oob_offset, u8 *ptr_oob, u32 oob_len,
+				     SPI_NAND_FLASH_WRITE_SPEED_MODE_T speed_mode)
+{
+	struct SPI_NAND_FLASH_INFO_T *ptr_dev_info_t = _SPI_NAND_GET_DEVICE_INFO_PTR;
+
+	if (full_page)
+	{
+		spi_nand_protocol_program_load(0, ptr_data, data_len, speed_mode);
+		return;
+	}
+	if (data_len > 0)
+		spi_nand_protocol_program_load_random(data_offset, ptr_data, data_len, speed_mode);
+	if (ECC_fcheck && oob_len > 0) /* Write OOB */
+		spi_nand_protocol_program_load_random(ptr_dev_info_t->page_size + oob_offset, ptr_oob, oob_len, speed_mode);
+}
+
+static SPI_NAND_FLASH_RTN_T spi_nand_write_page(u32 page_number, u32 data_offset, u8 *ptr_data, u32 data_len, u32 oob_offset, u8 *ptr_oob,
 						u32 oob_len, SPI_NAND_FLASH_WRITE_SPEED_MODE_T speed_mode)
 {
 	u8 status, status_2;
 	struct SPI_NAND_FLASH_INFO_T *ptr_dev_info_t;
 	SPI_NAND_FLASH_RTN_T rtn_status = SPI_NAND_FLASH_RTN_NO_ERROR;
-	u16 write_addr;
+	bool full_page;
 
-	int only_ffff = 1;
+	int only_ffff = !(ECC_fcheck && oob_len > 0);
 
 	for (int i = 0; (u32)i < data_len; i++)
 	{
@@ -523,38 +634,34 @@ static SPI_NAND_FLASH_RTN_T spi_nand_write_page(u32 page_number, u32 data_offset
 		return 0;
 	}
 
-	/* write to write_addr index in the page */
-	write_addr = 0;
-
 	/* Switch to manual mode*/
 	_SPI_NAND_ENABLE_MANUAL_MODE();
 
 	ptr_dev_info_t = _SPI_NAND_GET_DEVICE_INFO_PTR;
 
-	/* Read Current page data to software cache buffer */
-	rtn_status = spi_nand_read_page(page_number, (SPI_NAND_FLASH_READ_SPEED_MODE_T)speed_mode);
-	if (Skip_BAD_page && (rtn_status == SPI_NAND_FLASH_RTN_DETECTED_BAD_BLOCK))
-	{ /* skip BAD page, go to next page */
-		return SPI_NAND_FLASH_RTN_DETECTED_BAD_BLOCK;
-	}
-
-	/* Rewrite the software cache buffer */
-	if (data_len > 0)
-	{
-		memcpy(&_current_cache_page_data[data_offset], &ptr_data[0], data_len);
-	}
-
-	memcpy(&_current_cache_page[0], &_current_cache_page_data[0], ptr_dev_info_t->page_size);
-
-	if (ECC_fcheck && oob_len > 0) /* Write OOB */
+	/*
+	 * A whole page with no OOB of its own is loaded straight from the
+	 * caller's buffer: Program Load leaves every cache byte it is not given
+	 * at 0xFF, which programs nothing, so the spare area keeps what it
+	 * holds. Anything less is patched into the page inside the chip: Page
+	 * Read fills its cache and Random Program Load overwrites just the
+	 * given bytes, so the rest of the page never crosses the bus. That
+	 * Page Read is also where the ECC check finds the pages -k skips.
+	 */
+	full_page = (data_offset == 0) && (data_len == ptr_dev_info_t->page_size) &&
+		    !(ECC_fcheck && oob_len > 0) && !Skip_BAD_page;
+
+	if (!full_page)
 	{
-		memcpy(&_current_cache_page_oob[0], &ptr_oob[0], oob_len);
-		if (ptr_dev_info_t->oob_size)
-			memcpy(&_current_cache_page[ptr_dev_info_t->page_size], &_current_cache_page_oob[0], ptr_dev_info_t->oob_size);
+		rtn_status = spi_nand_load_page_into_cache(page_number);
+		if (Skip_BAD_page && (rtn_status == SPI_NAND_FLASH_RTN_DETECTED_BAD_BLOCK))
+		{ /* skip BAD page, go to next page */
+			return SPI_NAND_FLASH_RTN_DETECTED_BAD_BLOCK;
+		}
 	}
 
-	_SPI_NAND_DEBUG_PRINTF(SPI_NAND_FLASH_DEBUG_LEVEL_2, "spi_nand_write_page: page = 0x%x, data_offset = 0x%x, date_len = 0x%x, oob_offset = 0x%x, oob_len = 0x%x\n", page_number, data_offset, data_len, oob_offset, oob_len);
-	_SPI_NAND_DEBUG_PRINTF_ARRAY(SPI_NAND_FLASH_DEBUG_LEVEL_2, &_current_cache_page[0], ((ptr_dev_info_t->page_size) + (ptr_dev_info_t->oob_size)));
+	_SPI_NAND_DEBUG_PRINTF(SPI_NAND_FLASH_DEBUG_LEVEL_2, "spi_nand_write_page: page = 0x%x, data_offset = 0x%x, date_len = 0x%x, oob_offset = 0x%x, oob_len = 0x%x, full_page = %d\n", page_number, data_offset, data_len, oob_offset, oob_len, full_page);
+	_SPI_NAND_DEBUG_PRINTF_ARRAY(SPI_NAND_FLASH_DEBUG_LEVEL_2, ptr_data, data_len);
 
 	if (((ptr_dev_info_t->feature) & SPI_NAND_FLASH_PLANE_SELECT_HAVE))
 	{
@@ -565,6 +672,9 @@ static SPI_NAND_FLASH_RTN_T spi_nand_write_page(u32 page_number, u32 data_offset
 
 	spi_nand_select_die(page_number);
 
+	/* WREN, program load and program execute are queued and sent together */
+	_SPI_NAND_QUEUE_BEGIN();
+
 	/* Different Manafacture have different prgoram flow and setting */
 	if (((ptr_dev_info_t->mfr_id) == _SPI_NAND_MANUFACTURER_ID_GIGADEVICE) ||
 	    ((ptr_dev_info_t->mfr_id) == _SPI_NAND_MANUFACTURER_ID_PN) ||
@@ -576,9 +686,7 @@ static SPI_NAND_FLASH_RTN_T spi_nand_write_page(u32 page_number, u32 data_offset
 	    ((ptr_dev_info_t->mfr_id) == _SPI_NAND_MANUFACTURER_ID_ATO_2) ||
 	    (((ptr_dev_info_t->mfr_id) == _SPI_NAND_MANUFACTURER_ID_ATO) && ((ptr_dev_info_t->dev_id) == _SPI_NAND_DEVICE_ID_ATO25D2GA)))
 	{
-		{
-			spi_nand_protocol_program_load(write_addr, &_current_cache_page[0], ((ptr_dev_info_t->page_size) + (ptr_dev_info_t->oob_size)), speed_mode);
-		}
+		spi_nand_write_page_load(full_page, data_offset, ptr_data, data_len, oob_offset, ptr_oob, oob_len, speed_mode);
 
 		/* Enable write_to flash */
 		spi_nand_protocol_write_enable();
@@ -588,20 +696,16 @@ static SPI_NAND_FLASH_RTN_T spi_nand_write_page(u32 page_number, u32 data_offset
 		/* Enable write_to flash */
 		spi_nand_protocol_write_enable();
 
-		{
-			/* Program data into buffer of SPI NAND chip */
-			spi_nand_protocol_program_load(write_addr, &_current_cache_page[0], ((ptr_dev_info_t->page_size) + (ptr_dev_info_t->oob_size)), speed_mode);
-		}
+		/* Program data into buffer of SPI NAND chip */
+		spi_nand_write_page_load(full_page, data_offset, ptr_data, data_len, oob_offset, ptr_oob, oob_len, speed_mode);
 	}
 
 	/* Execute program data into SPI NAND chip  */
 	spi_nand_protocol_program_execute(page_number);
+	_SPI_NAND_QUEUE_END();
 
 	/* Checking status for erase complete */
-	do
-	{
-		spi_nand_protocol_get_status_reg_3(&status);
-	} while (status & _SPI_NAND_VAL_OIP);
+	spi_nand_protocol_wait_ready(&status);
 
 	/*. Disable write_flash */
 	spi_nand_protocol_write_disable();
@@ -684,10 +788,14 @@ static SPI_NAND_FLASH_RTN_T spi_nand_read_internal(u32 addr, u32 len, u8 *ptr_rt
 {
 	u32 page_number, data_offset;
 	u32 read_addr, physical_read_addr, remain_len;
+	u32 pages_per_block, run_pages, first_len, seq_last_page = 0, cont_resume_page = 0;
+	bool seq_active = false;
+	u8 *cont_buf = NULL, *ptr_page_buf;
 	struct SPI_NAND_FLASH_INFO_T *ptr_dev_info_t;
 	SPI_NAND_FLASH_RTN_T rtn_status = SPI_NAND_FLASH_RTN_NO_ERROR;
 
 	ptr_dev_info_t = _SPI_NAND_GET_DEVICE_INFO_PTR;
+	pages_per_block = ptr_dev_info_t->erase_size / ptr_dev_info_t->page_size;
 
 	read_addr = addr;
 	remain_len = len;
@@ -697,6 +805,10 @@ static SPI_NAND_FLASH_RTN_T spi_nand_read_internal(u32 addr, u32 len, u8 *ptr_rt
 
 	*status = SPI_NAND_FLASH_RTN_NO_ERROR;
 
+	/* One block of pages with their OOB, as the continuous read streams them */
+	if (Cont_read && (ptr_dev_info_t->feature & SPI_NAND_FLASH_CONT_READ_HAVE))
+		cont_buf = malloc(pages_per_block * ((ptr_dev_info_t->page_size) + (ptr_dev_info_t->oob_size)));
+
 	while (remain_len > 0)
 	{
 		physical_read_addr = read_addr;
@@ -707,12 +819,68 @@ static SPI_NAND_FLASH_RTN_T spi_nand_read_internal(u32 addr, u32 len, u8 *ptr_rt
 
 		_SPI_NAND_DEBUG_PRINTF(SPI_NAND_FLASH_DEBUG_LEVEL_1, "spi_nand_read_internal: read_addr = 0x%x, page_number = 0x%x, data_offset = 0x%x\n", physical_read_addr, page_number, data_offset);
 
-	rtn_status = spi_nand_read_page(page_number, (SPI_NAND_FLASH_READ_SPEED_MODE_T)speed_mode);
+		/* Pages of the request left in this block */
+		first_len = ptr_dev_info_t->page_size - data_offset;
+		run_pages = (remain_len <= first_len) ? 1 : 1 + (remain_len - first_len + ptr_dev_info_t->page_size - 1) / ptr_dev_info_t->page_size;
+		if (run_pages > pages_per_block - page_number % pages_per_block)
+			run_pages = pages_per_block - page_number % pages_per_block;
+
+		/* Stream them in one continuous read. An uncorrectable run is read
+		 * again page by page to find, report or skip the bad page. */
+		if (cont_buf && run_pages > 1 && page_number >= cont_resume_page)
+		{
+			if (spi_nand_read_cont(page_number, run_pages, cont_buf) == SPI_NAND_FLASH_RTN_NO_ERROR)
+			{
+				for (u32 i = 0; i < run_pages; i++)
+				{
+					u32 chunk = (remain_len < first_len) ? remain_len : first_len;
+
+					memcpy(&ptr_rtn_buf[len - remain_len], &cont_buf[i * ((ptr_dev_info_t->page_size) + (ptr_dev_info_t->oob_size)) + data_offset], chunk);
+					remain_len -= chunk;
+					read_addr += chunk;
+					data_offset = 0;
+					first_len = ptr_dev_info_t->page_size;
+				}
+				timer_progress("Read", len - remain_len, len);
+				continue;
+			}
+			cont_resume_page = page_number + run_pages;
+		}
+
+		/* Start a sequential cache read over the pages left in this block */
+		if (!seq_active && (ptr_dev_info_t->feature & SPI_NAND_FLASH_CACHE_READ_HAVE) && _current_page_num != page_number)
+		{
+			if (run_pages > 1)
+			{
+				spi_nand_read_seq_begin(page_number);
+				seq_last_page = page_number + run_pages - 1;
+				seq_active = true;
+			}
+		}
+
+		/* Whole pages go straight into the caller's buffer when there is room
+		 * for the OOB behind them; the next page overwrites it. Head and tail
+		 * fragments go through the host page cache. */
+		ptr_page_buf = NULL;
+		if (data_offset == 0 && remain_len >= (ptr_dev_info_t->page_size) + (ptr_dev_info_t->oob_size) && _current_page_num != page_number)
+			ptr_page_buf = &ptr_rtn_buf[len - remain_len];
+
+		if (seq_active)
+		{
+			rtn_status = spi_nand_read_page_seq(page_number, page_number == seq_last_page, ptr_page_buf, (SPI_NAND_FLASH_READ_SPEED_MODE_T)speed_mode);
+			seq_active = (page_number != seq_last_page);
+		}
+		else
+			rtn_status = spi_nand_read_page(page_number, ptr_page_buf, (SPI_NAND_FLASH_READ_SPEED_MODE_T)speed_mode);
+
 		if (rtn_status == SPI_NAND_FLASH_RTN_DETECTED_BAD_BLOCK)
 		{
 			if (!Skip_BAD_page)
 			{
+				if (seq_active)
+					spi_nand_read_seq_abort();
 				*status = SPI_NAND_FLASH_RTN_DETECTED_BAD_BLOCK;
+				free(cont_buf);
 				return (rtn_status);
 			}
 			/* skip BAD page, go to next page */
@@ -723,14 +891,19 @@ static SPI_NAND_FLASH_RTN_T spi_nand_read_internal(u32 addr, u32 len, u8 *ptr_rt
 		}
 
 		/* 3. Retrieve the request data */
-		if ((data_offset + remain_len) < ptr_dev_info_t->page_size)
+		if (ptr_page_buf)
 		{
-			memcpy(&ptr_rtn_buf[len - remain_len], &_current_cache_page_data[data_offset], (sizeof(unsigned char) * remain_len));
+			remain_len -= ptr_dev_info_t->page_size;
+			read_addr += ptr_dev_info_t->page_size;
+		}
+		else if ((data_offset + remain_len) < ptr_dev_info_t->page_size)
+		{
+			memcpy(&ptr_rtn_buf[len - remain_len], &_current_cache_page[data_offset], (sizeof(unsigned char) * remain_len));
 			remain_len = 0;
 		}
 		else
 		{
-			memcpy(&ptr_rtn_buf[len - remain_len], &_current_cache_page_data[data_offset], (sizeof(unsigned char) * (ptr_dev_info_t->page_size - data_offset)));
+			memcpy(&ptr_rtn_buf[len - remain_len], &_current_cache_page[data_offset], (sizeof(unsigned char) * (ptr_dev_info_t->page_size - data_offset)));
 			remain_len -= (ptr_dev_info_t->page_size - data_offset);
 			read_addr += (ptr_dev_info_t->page_size - data_offset);
 		}
@@ -738,6 +911,7 @@ static SPI_NAND_FLASH_RTN_T spi_nand_read_internal(u32 addr, u32 len, u8 *ptr_rt
 	}
 	printf("\rRead 100%% [%u] of [%u] bytes      \n", len - remain_len, len);
 
+	free(cont_buf);
 	return (rtn_status);
 }
 
@@ -1023,63 +1197,63 @@ static void spi_nand_populate_device_info(
 	target_info->feature = table_entry->feature;
 }
 
+/*
+ * Find the table entry for the ID just read. The chipdb_gen index gives the
+ * entries sharing mfr_id and dev_id in table order; with match_id_2 an entry
+ * listing a dev_id_2 must match that as well.
+ */
+static const struct SPI_NAND_FLASH_INFO_T *spi_nand_lookup(
+    const struct SPI_NAND_FLASH_INFO_T *ptr_device_t, bool match_id_2)
+{
+	const struct chipdb_slot *slot;
+	const struct SPI_NAND_FLASH_INFO_T *entry;
+	u32 i;
+
+	slot = chipdb_find(snand_index_slots, SNAND_INDEX_MULT, SNAND_INDEX_BITS,
+			   CHIPDB_NAND_KEY(ptr_device_t->mfr_id, ptr_device_t->dev_id));
+	if (!slot)
+		return NULL;
+	for (i = slot->first; i < (u32)slot->first + slot->count; i++) {
+		entry = &spi_nand_flash_tables[snand_index_order[i]];
+		if (!match_id_2 || spi_nand_compare(ptr_device_t, entry) == SPI_NAND_FLASH_RTN_NO_ERROR)
+			return entry;
+	}
+	return NULL;
+}
+
 /* Probe SPI NAND flash ID */
 static SPI_NAND_FLASH_RTN_T spi_nand_probe(struct SPI_NAND_FLASH_INFO_T *ptr_rtn_device_t)
 {
-	u32 i = 0;
-	size_t table_size = get_spi_nand_flash_table_size();
+	const struct SPI_NAND_FLASH_INFO_T *entry;
 	SPI_NAND_FLASH_RTN_T rtn_status = SPI_NAND_FLASH_RTN_PROBE_ERROR;
 
 	_SPI_NAND_DEBUG_PRINTF(SPI_NAND_FLASH_DEBUG_LEVEL_1, "spi_nand_probe: start \n");
 
 	/* Protocol for read id */
 	spi_nand_protocol_read_id(ptr_rtn_device_t);
+	entry = spi_nand_lookup(ptr_rtn_device_t, true);
 
-	for (i = 0; i < table_size; i++)
-	{
-		if (spi_nand_compare(ptr_rtn_device_t, &spi_nand_flash_tables[i]) == SPI_NAND_FLASH_RTN_NO_ERROR)
-		{
-			spi_nand_populate_device_info(ptr_rtn_device_t, &spi_nand_flash_tables[i]);
-			rtn_status = SPI_NAND_FLASH_RTN_NO_ERROR;
-			break;
-		}
-	}
-
-	if (rtn_status != SPI_NAND_FLASH_RTN_NO_ERROR)
+	if (!entry)
 	{
 		/* Another protocol for read id  (For example, the GigaDevice SPI NAND chip for Type C */
 		spi_nand_protocol_read_id_2(ptr_rtn_device_t);
-
-		for (i = 0; i < table_size; i++)
-		{
-			if (spi_nand_compare(ptr_rtn_device_t, &spi_nand_flash_tables[i]) == SPI_NAND_FLASH_RTN_NO_ERROR)
-			{
-				spi_nand_populate_device_info(ptr_rtn_device_t, &spi_nand_flash_tables[i]);
-				rtn_status = SPI_NAND_FLASH_RTN_NO_ERROR;
-				break;
-			}
-		}
+		entry = spi_nand_lookup(ptr_rtn_device_t, true);
 	}
 
-	if (rtn_status != SPI_NAND_FLASH_RTN_NO_ERROR)
+	if (!entry)
 	{
 		/* Another protocol for read id (For example, the Toshiba/KIOXIA SPI NAND chip */
 		spi_nand_protocol_read_id_3(ptr_rtn_device_t);
+		entry = spi_nand_lookup(ptr_rtn_device_t, false);
+	}
 
-		for (i = 0; i < table_size; i++)
-		{
-			_SPI_NAND_DEBUG_PRINTF(SPI_NAND_FLASH_DEBUG_LEVEL_1,
-					       "spi_nand_probe: table[%d]: mfr_id = 0x%x, dev_id = 0x%x\n", i,
-					       spi_nand_flash_tables[i].mfr_id, spi_nand_flash_tables[i].dev_id);
-
-			if (((ptr_rtn_device_t->mfr_id) == spi_nand_flash_tables[i].mfr_id) &&
-			    ((ptr_rtn_device_t->dev_id) == spi_nand_flash_tables[i].dev_id))
-			{
-				spi_nand_populate_device_info(ptr_rtn_device_t, &spi_nand_flash_tables[i]);
-				rtn_status = SPI_NAND_FLASH_RTN_NO_ERROR;
-				break;
-			}
-		}
+	if (entry)
+	{
+		_SPI_NAND_DEBUG_PRINTF(SPI_NAND_FLASH_DEBUG_LEVEL_1,
+				       "spi_nand_probe: table[%d]: %s\n",
+				       (int)(entry - spi_nand_flash_tables), entry->ptr_name);
+		spi_nand_populate_device_info(ptr_rtn_device_t, entry);
+		rtn_status = SPI_NAND_FLASH_RTN_NO_ERROR;
 	}
 
 	if (ptr_rtn_device_t->dev_id_2 == 0)
@@ -1155,6 +1329,8 @@ SPI_NAND_FLASH_RTN_T SPI_NAND_Flash_Init(u32 rom_base __attribute__((unused)))
 		       OOB_size ? (unsigned long)OOB_size : bmt_oob_size);
 		printf("SPI device ID: mfr 0x%02x, dev 0x%04x\n",
 		       _current_flash_info_t.mfr_id, _current_flash_info_t.dev_id);
+		if (Cont_read && !(_current_flash_info_t.feature & SPI_NAND_FLASH_CONT_READ_HAVE))
+			printf("Continuous read not supported by this chip, reading page by page.\n");
 
 		rtn_status = SPI_NAND_FLASH_RTN_NO_ERROR;
 	}
@@ -64,6 +64,8 @@ typedef enum
 #define SPI_NAND_FLASH_PLANE_SELECT_HAVE (0x01 << 0)
 #define SPI_NAND_FLASH_DIE_SELECT_1_HAVE (0x01 << 1)
 #define SPI_NAND_FLASH_DIE_SELECT_2_HAVE (0x01 << 2)
+#define SPI_NAND_FLASH_CACHE_READ_HAVE (0x01 << 3)   /* 0x31/0x3F sequential cache read */
+#define SPI_NAND_FLASH_CONT_READ_HAVE (0x01 << 4)    /* continuous read with BUF cleared */
 
 // Structure holding information about a specific SPI NAND flash chip.
 struct SPI_NAND_FLASH_INFO_T
@@ -22,6 +22,8 @@
 #define _SPI_NAND_OP_GET_FEATURE 0x0F                 /* Get Feature */
 #define _SPI_NAND_OP_SET_FEATURE 0x1F                 /* Set Feature */
 #define _SPI_NAND_OP_PAGE_READ 0x13                   /* Load page data into cache of SPI NAND chip */
+#define _SPI_NAND_OP_PAGE_READ_CACHE_SEQ 0x31         /* Move loaded page to cache, start loading the next one */
+#define _SPI_NAND_OP_PAGE_READ_CACHE_LAST 0x3F        /* Move loaded page to cache, end the sequential read */
 #define _SPI_NAND_OP_READ_FROM_CACHE_SINGLE 0x03      /* Read data from cache of SPI NAND chip, single speed*/
 #define _SPI_NAND_OP_READ_FROM_CACHE_DUAL 0x3B        /* Read data from cache of SPI NAND chip, dual speed*/
 #define _SPI_NAND_OP_READ_FROM_CACHE_QUAD 0x6B        /* Read data from cache of SPI NAND chip, quad speed*/
@@ -55,6 +57,7 @@
 #define _SPI_NAND_VAL_ERASE_FAIL 0x4                  /* E_FAIL = Erase Fail */
 #define _SPI_NAND_VAL_PROGRAM_FAIL 0x8                /* P_FAIL = Program Fail */
 #define _SPI_NAND_VAL_ECC_ENABLE 0x10                 /* ECC Enable bit */
+#define _SPI_NAND_VAL_BUF 0x08                        /* Winbond buffer read mode, cleared for continuous read */
 /* ECC Status bits (Status Register C0h) - Note: Interpretation varies by manufacturer! */
 #define _SPI_NAND_VAL_ECC_STATUS_MASK_30 0x30         /* Common mask for 2-bit ECC status */
 #define _SPI_NAND_VAL_ECC_STATUS_MASK_70 0x70         /* Common mask for 3-bit ECC status */
@@ -307,6 +310,11 @@ void _SPI_NAND_DEBUG_PRINTF_ARRAY(int level, u8 *array, int len)
 #define _SPI_NAND_READ_NBYTE(ptr, len, speed) SPI_CONTROLLER_Read_NByte(ptr, len)
 #define _SPI_NAND_READ_CHIP_SELECT_HIGH SPI_CONTROLLER_Chip_Select_High
 #define _SPI_NAND_READ_CHIP_SELECT_LOW SPI_CONTROLLER_Chip_Select_Low
+#define _SPI_NAND_TRANSACTION(wptr, wlen, rptr, rlen) SPI_CONTROLLER_Transaction(wptr, wlen, rptr, rlen)
+#define _SPI_NAND_READ_DUAL(cptr, clen, op, rptr, rlen) SPI_CONTROLLER_Read_Dual(cptr, clen, op, rptr, rlen)
+#define _SPI_NAND_POLL_STATUS(cptr, clen, mask, count, sptr, iptr) SPI_CONTROLLER_Poll_Status(cptr, clen, mask, count, sptr, iptr)
+#define _SPI_NAND_QUEUE_BEGIN SPI_CONTROLLER_Queue_Begin
+#define _SPI_NAND_QUEUE_END SPI_CONTROLLER_Queue_End
 
 /* spi_nand_flash_protocol.c function prototypes */
 SPI_NAND_FLASH_RTN_T spi_nand_protocol_set_feature(u8 addr, u8 data);
@@ -316,6 +324,7 @@ SPI_NAND_FLASH_RTN_T spi_nand_protocol_get_status_reg_1(u8 *ptr_rtn_protection);
 SPI_NAND_FLASH_RTN_T spi_nand_protocol_set_status_reg_2(u8 feature);
 SPI_NAND_FLASH_RTN_T spi_nand_protocol_get_status_reg_2(u8 *ptr_rtn_feature);
 SPI_NAND_FLASH_RTN_T spi_nand_protocol_get_status_reg_3(u8 *ptr_rtn_status);
+SPI_NAND_FLASH_RTN_T spi_nand_protocol_wait_ready(u8 *ptr_rtn_status);
 SPI_NAND_FLASH_RTN_T spi_nand_protocol_set_status_reg_4(u8 feature);
 SPI_NAND_FLASH_RTN_T spi_nand_protocol_get_status_reg_4(u8 *ptr_rtn_status);
 SPI_NAND_FLASH_RTN_T spi_nand_protocol_get_status_reg_5(u8 *ptr_rtn_status);
@@ -326,8 +335,10 @@ SPI_NAND_FLASH_RTN_T spi_nand_protocol_read_id(struct SPI_NAND_FLASH_INFO_T *ptr
 SPI_NAND_FLASH_RTN_T spi_nand_protocol_read_id_2(struct SPI_NAND_FLASH_INFO_T *ptr_rtn_flash_id);
 SPI_NAND_FLASH_RTN_T spi_nand_protocol_read_id_3(struct SPI_NAND_FLASH_INFO_T *ptr_rtn_flash_id);
 SPI_NAND_FLASH_RTN_T spi_nand_protocol_page_read(u32 page_number);
+SPI_NAND_FLASH_RTN_T spi_nand_protocol_page_read_cache(bool last);
 SPI_NAND_FLASH_RTN_T spi_nand_protocol_read_from_cache(u32 data_offset, u32 len, u8 *ptr_rtn_buf, u32 read_mode, SPI_NAND_FLASH_READ_DUMMY_BYTE_T dummy_mode);
 SPI_NAND_FLASH_RTN_T spi_nand_protocol_program_load(u32 addr, u8 *ptr_data, u32 len, u32 write_mode);
+SPI_NAND_FLASH_RTN_T spi_nand_protocol_program_load_random(u32 addr, u8 *ptr_data, u32 len, u32 write_mode);
 SPI_NAND_FLASH_RTN_T spi_nand_protocol_program_execute(u32 addr);
 SPI_NAND_FLASH_RTN_T spi_nand_protocol_die_select_1(u8 die_id);
 SPI_NAND_FLASH_RTN_T spi_nand_protocol_die_select_2(u8 die_id);
@@ -12,8 +12,7 @@
  * 
  * Optimizations:
  * - Reduces redundant protocol calls by caching status register values
- * - Minimizes chip select transitions for better throughput
- * - Uses efficient command batching where possible
+ * - Issues every command as a single CS-framed controller transaction
  */
 
 #include "spi_nand_flash.h"
@@ -37,45 +36,21 @@ static SPI_NAND_FLASH_RTN_T spi_nand_protocol_get_status_reg_3_cached(u8 *ptr_rt
 /* Set feature register */
 SPI_NAND_FLASH_RTN_T spi_nand_protocol_set_feature(u8 addr, u8 data)
 {
+	u8 cmd[3] = { _SPI_NAND_OP_SET_FEATURE, addr, data };
 	SPI_CONTROLLER_RTN_T spi_ret;
-	_SPI_NAND_READ_CHIP_SELECT_LOW(); // Assuming CS control doesn't fail easily
-	spi_ret = _SPI_NAND_WRITE_ONE_BYTE(_SPI_NAND_OP_SET_FEATURE);
-	if (spi_ret != SPI_CONTROLLER_RTN_NO_ERROR)
-		goto spi_fail;
-	spi_ret = _SPI_NAND_WRITE_ONE_BYTE(addr);
-	if (spi_ret != SPI_CONTROLLER_RTN_NO_ERROR)
-		goto spi_fail;
-	spi_ret = _SPI_NAND_WRITE_ONE_BYTE(data);
-	if (spi_ret != SPI_CONTROLLER_RTN_NO_ERROR)
-		goto spi_fail;
-	_SPI_NAND_READ_CHIP_SELECT_HIGH();
-	return SPI_NAND_FLASH_RTN_NO_ERROR;
 
-spi_fail:
-	_SPI_NAND_READ_CHIP_SELECT_HIGH();
-	return SPI_NAND_FLASH_RTN_SPI_CTRL_FAIL;
+	spi_ret = _SPI_NAND_TRANSACTION(cmd, sizeof(cmd), NULL, 0);
+	return (spi_ret == SPI_CONTROLLER_RTN_NO_ERROR) ? SPI_NAND_FLASH_RTN_NO_ERROR : SPI_NAND_FLASH_RTN_SPI_CTRL_FAIL;
 }
 
 /* Get feature register */
 SPI_NAND_FLASH_RTN_T spi_nand_protocol_get_feature(u8 addr, u8 *ptr_rtn_data)
 {
+	u8 cmd[2] = { _SPI_NAND_OP_GET_FEATURE, addr };
 	SPI_CONTROLLER_RTN_T spi_ret;
-	_SPI_NAND_READ_CHIP_SELECT_LOW();
-	spi_ret = _SPI_NAND_WRITE_ONE_BYTE(_SPI_NAND_OP_GET_FEATURE);
-	if (spi_ret != SPI_CONTROLLER_RTN_NO_ERROR)
-		goto spi_fail;
-	spi_ret = _SPI_NAND_WRITE_ONE_BYTE(addr);
-	if (spi_ret != SPI_CONTROLLER_RTN_NO_ERROR)
-		goto spi_fail;
-	spi_ret = _SPI_NAND_READ_NBYTE(ptr_rtn_data, _SPI_NAND_LEN_ONE_BYTE, SPI_CONTROLLER_SPEED_SINGLE);
-	if (spi_ret != SPI_CONTROLLER_RTN_NO_ERROR)
-		goto spi_fail;
-	_SPI_NAND_READ_CHIP_SELECT_HIGH();
-	return SPI_NAND_FLASH_RTN_NO_ERROR;
 
-spi_fail:
-	_SPI_NAND_READ_CHIP_SELECT_HIGH();
-	return SPI_NAND_FLASH_RTN_SPI_CTRL_FAIL;
+	spi_ret = _SPI_NAND_TRANSACTION(cmd, sizeof(cmd), ptr_rtn_data, _SPI_NAND_LEN_ONE_BYTE);
+	return (spi_ret == SPI_CONTROLLER_RTN_NO_ERROR) ? SPI_NAND_FLASH_RTN_NO_ERROR : SPI_NAND_FLASH_RTN_SPI_CTRL_FAIL;
 }
 
 /*
@@ -153,6 +128,25 @@ SPI_NAND_FLASH_RTN_T spi_nand_protocol_get_status_reg_3(u8 *ptr_rtn_status)
 	return spi_nand_protocol_get_status_reg_3_cached(ptr_rtn_status);
 }
 
+/*
+ * Poll status register 3 until OIP clears, a run of samples per round trip
+ */
+#define SPI_NAND_POLL_SAMPLES 16
+
+SPI_NAND_FLASH_RTN_T spi_nand_protocol_wait_ready(u8 *ptr_rtn_status)
+{
+	u8 cmd[2] = { _SPI_NAND_OP_GET_FEATURE, _SPI_NAND_ADDR_STATUS };
+	u32 ready_idx;
+
+	do {
+		if (_SPI_NAND_POLL_STATUS(cmd, sizeof(cmd), _SPI_NAND_VAL_OIP, SPI_NAND_POLL_SAMPLES,
+					  ptr_rtn_status, &ready_idx) != SPI_CONTROLLER_RTN_NO_ERROR)
+			return SPI_NAND_FLASH_RTN_SPI_CTRL_FAIL;
+	} while (ready_idx == SPI_NAND_POLL_SAMPLES);
+
+	return SPI_NAND_FLASH_RTN_NO_ERROR;
+}
+
 /* Status register 4 operations */
 SPI_NAND_FLASH_RTN_T spi_nand_protocol_set_status_reg_4(u8 feature)
 {
@@ -173,132 +167,84 @@ SPI_NAND_FLASH_RTN_T spi_nand_protocol_get_status_reg_5(u8 *ptr_rtn_status)
 /* Write enable/disable */
 SPI_NAND_FLASH_RTN_T spi_nand_protocol_write_enable(void)
 {
+	u8 cmd = _SPI_NAND_OP_WRITE_ENABLE;
 	SPI_CONTROLLER_RTN_T spi_ret;
-	_SPI_NAND_READ_CHIP_SELECT_LOW();
-	spi_ret = _SPI_NAND_WRITE_ONE_BYTE(_SPI_NAND_OP_WRITE_ENABLE);
-	_SPI_NAND_READ_CHIP_SELECT_HIGH();
+
+	spi_ret = _SPI_NAND_TRANSACTION(&cmd, 1, NULL, 0);
 	return (spi_ret == SPI_CONTROLLER_RTN_NO_ERROR) ? SPI_NAND_FLASH_RTN_NO_ERROR : SPI_NAND_FLASH_RTN_SPI_CTRL_FAIL;
 }
 
 SPI_NAND_FLASH_RTN_T spi_nand_protocol_write_disable(void)
 {
+	u8 cmd = _SPI_NAND_OP_WRITE_DISABLE;
 	SPI_CONTROLLER_RTN_T spi_ret;
-	_SPI_NAND_READ_CHIP_SELECT_LOW();
-	spi_ret = _SPI_NAND_WRITE_ONE_BYTE(_SPI_NAND_OP_WRITE_DISABLE);
-	_SPI_NAND_READ_CHIP_SELECT_HIGH();
+
+	spi_ret = _SPI_NAND_TRANSACTION(&cmd, 1, NULL, 0);
 	return (spi_ret == SPI_CONTROLLER_RTN_NO_ERROR) ? SPI_NAND_FLASH_RTN_NO_ERROR : SPI_NAND_FLASH_RTN_SPI_CTRL_FAIL;
 }
 
 /* Block erase */
 SPI_NAND_FLASH_RTN_T spi_nand_protocol_block_erase(u32 block_idx)
 {
+	u8 cmd[4];
 	SPI_CONTROLLER_RTN_T spi_ret;
-	_SPI_NAND_READ_CHIP_SELECT_LOW();
-	spi_ret = _SPI_NAND_WRITE_ONE_BYTE(_SPI_NAND_OP_BLOCK_ERASE);
-	if (spi_ret != SPI_CONTROLLER_RTN_NO_ERROR)
-		goto spi_fail;
 
 	block_idx = block_idx << _SPI_NAND_BLOCK_ROW_ADDRESS_OFFSET;
-	spi_ret = _SPI_NAND_WRITE_ONE_BYTE((block_idx >> 16) & 0xff);
-	if (spi_ret != SPI_CONTROLLER_RTN_NO_ERROR)
-		goto spi_fail;
-	spi_ret = _SPI_NAND_WRITE_ONE_BYTE((block_idx >> 8) & 0xff);
-	if (spi_ret != SPI_CONTROLLER_RTN_NO_ERROR)
-		goto spi_fail;
-	spi_ret = _SPI_NAND_WRITE_ONE_BYTE(block_idx & 0xff);
-	if (spi_ret != SPI_CONTROLLER_RTN_NO_ERROR)
-		goto spi_fail;
-
-	_SPI_NAND_READ_CHIP_SELECT_HIGH();
-	return SPI_NAND_FLASH_RTN_NO_ERROR;
+	cmd[0] = _SPI_NAND_OP_BLOCK_ERASE;
+	cmd[1] = (block_idx >> 16) & 0xff;
+	cmd[2] = (block_idx >> 8) & 0xff;
+	cmd[3] = block_idx & 0xff;
 
-spi_fail:
-	_SPI_NAND_READ_CHIP_SELECT_HIGH();
-	return SPI_NAND_FLASH_RTN_SPI_CTRL_FAIL;
+	spi_ret = _SPI_NAND_TRANSACTION(cmd, sizeof(cmd), NULL, 0);
+	return (spi_ret == SPI_CONTROLLER_RTN_NO_ERROR) ? SPI_NAND_FLASH_RTN_NO_ERROR : SPI_NAND_FLASH_RTN_SPI_CTRL_FAIL;
 }
 
 /* Read ID methods */
 SPI_NAND_FLASH_RTN_T spi_nand_protocol_read_id(struct SPI_NAND_FLASH_INFO_T *ptr_rtn_flash_id)
 {
+	u8 cmd[2] = { _SPI_NAND_OP_READ_ID, _SPI_NAND_ADDR_MANUFACTURE_ID };
+	u8 id[3];
 	SPI_CONTROLLER_RTN_T spi_ret;
-	_SPI_NAND_READ_CHIP_SELECT_LOW();
-	spi_ret = _SPI_NAND_WRITE_ONE_BYTE(_SPI_NAND_OP_READ_ID);
-	if (spi_ret != SPI_CONTROLLER_RTN_NO_ERROR)
-		goto spi_fail;
-	spi_ret = _SPI_NAND_WRITE_ONE_BYTE(_SPI_NAND_ADDR_MANUFACTURE_ID);
-	if (spi_ret != SPI_CONTROLLER_RTN_NO_ERROR)
-		goto spi_fail;
 
-	spi_ret = _SPI_NAND_READ_NBYTE(&(ptr_rtn_flash_id->mfr_id), _SPI_NAND_LEN_ONE_BYTE, SPI_CONTROLLER_SPEED_SINGLE);
-	if (spi_ret != SPI_CONTROLLER_RTN_NO_ERROR)
-		goto spi_fail;
-	spi_ret = _SPI_NAND_READ_NBYTE(&(ptr_rtn_flash_id->dev_id), _SPI_NAND_LEN_ONE_BYTE, SPI_CONTROLLER_SPEED_SINGLE);
-	if (spi_ret != SPI_CONTROLLER_RTN_NO_ERROR)
-		goto spi_fail;
-	spi_ret = _SPI_NAND_READ_NBYTE(&(ptr_rtn_flash_id->dev_id_2), _SPI_NAND_LEN_ONE_BYTE, SPI_CONTROLLER_SPEED_SINGLE);
+	spi_ret = _SPI_NAND_TRANSACTION(cmd, sizeof(cmd), id, sizeof(id));
 	if (spi_ret != SPI_CONTROLLER_RTN_NO_ERROR)
-		goto spi_fail;
+		return SPI_NAND_FLASH_RTN_SPI_CTRL_FAIL;
 
-	_SPI_NAND_READ_CHIP_SELECT_HIGH();
+	ptr_rtn_flash_id->mfr_id = id[0];
+	ptr_rtn_flash_id->dev_id = id[1];
+	ptr_rtn_flash_id->dev_id_2 = id[2];
 	return SPI_NAND_FLASH_RTN_NO_ERROR;
-
-spi_fail:
-	_SPI_NAND_READ_CHIP_SELECT_HIGH();
-	return SPI_NAND_FLASH_RTN_SPI_CTRL_FAIL;
 }
 
 SPI_NAND_FLASH_RTN_T spi_nand_protocol_read_id_2(struct SPI_NAND_FLASH_INFO_T *ptr_rtn_flash_id)
 {
+	u8 cmd = _SPI_NAND_OP_READ_ID;
+	u8 id[3];
 	SPI_CONTROLLER_RTN_T spi_ret;
-	_SPI_NAND_READ_CHIP_SELECT_LOW();
-	spi_ret = _SPI_NAND_WRITE_ONE_BYTE(_SPI_NAND_OP_READ_ID);
-	if (spi_ret != SPI_CONTROLLER_RTN_NO_ERROR)
-		goto spi_fail;
 
-	spi_ret = _SPI_NAND_READ_NBYTE(&(ptr_rtn_flash_id->mfr_id), _SPI_NAND_LEN_ONE_BYTE, SPI_CONTROLLER_SPEED_SINGLE);
-	if (spi_ret != SPI_CONTROLLER_RTN_NO_ERROR)
-		goto spi_fail;
-	spi_ret = _SPI_NAND_READ_NBYTE(&(ptr_rtn_flash_id->dev_id), _SPI_NAND_LEN_ONE_BYTE, SPI_CONTROLLER_SPEED_SINGLE);
+	spi_ret = _SPI_NAND_TRANSACTION(&cmd, 1, id, sizeof(id));
 	if (spi_ret != SPI_CONTROLLER_RTN_NO_ERROR)
-		goto spi_fail;
-	spi_ret = _SPI_NAND_READ_NBYTE(&(ptr_rtn_flash_id->dev_id_2), _SPI_NAND_LEN_ONE_BYTE, SPI_CONTROLLER_SPEED_SINGLE);
-	if (spi_ret != SPI_CONTROLLER_RTN_NO_ERROR)
-		goto spi_fail;
+		return SPI_NAND_FLASH_RTN_SPI_CTRL_FAIL;
 
-	_SPI_NAND_READ_CHIP_SELECT_HIGH();
+	ptr_rtn_flash_id->mfr_id = id[0];
+	ptr_rtn_flash_id->dev_id = id[1];
+	ptr_rtn_flash_id->dev_id_2 = id[2];
 	return SPI_NAND_FLASH_RTN_NO_ERROR;
-
-spi_fail:
-	_SPI_NAND_READ_CHIP_SELECT_HIGH();
-	return SPI_NAND_FLASH_RTN_SPI_CTRL_FAIL;
 }
 
 SPI_NAND_FLASH_RTN_T spi_nand_protocol_read_id_3(struct SPI_NAND_FLASH_INFO_T *ptr_rtn_flash_id)
 {
-	u8 dummy = 0;
+	u8 cmd = _SPI_NAND_OP_READ_ID;
+	u8 id[3]; /* dummy, manufacturer, device */
 	SPI_CONTROLLER_RTN_T spi_ret;
 
-	_SPI_NAND_READ_CHIP_SELECT_LOW();
-	spi_ret = _SPI_NAND_WRITE_ONE_BYTE(_SPI_NAND_OP_READ_ID);
-	if (spi_ret != SPI_CONTROLLER_RTN_NO_ERROR)
-		goto spi_fail;
-
-	spi_ret = _SPI_NAND_READ_NBYTE(&dummy, _SPI_NAND_LEN_ONE_BYTE, SPI_CONTROLLER_SPEED_SINGLE);
-	if (spi_ret != SPI_CONTROLLER_RTN_NO_ERROR)
-		goto spi_fail;
-	spi_ret = _SPI_NAND_READ_NBYTE(&(ptr_rtn_flash_id->mfr_id), _SPI_NAND_LEN_ONE_BYTE, SPI_CONTROLLER_SPEED_SINGLE);
-	if (spi_ret != SPI_CONTROLLER_RTN_NO_ERROR)
-		goto spi_fail;
-	spi_ret = _SPI_NAND_READ_NBYTE(&(ptr_rtn_flash_id->dev_id), _SPI_NAND_LEN_ONE_BYTE, SPI_CONTROLLER_SPEED_SINGLE);
+	spi_ret = _SPI_NAND_TRANSACTION(&cmd, 1, id, sizeof(id));
 	if (spi_ret != SPI_CONTROLLER_RTN_NO_ERROR)
-		goto spi_fail;
+		return SPI_NAND_FLASH_RTN_SPI_CTRL_FAIL;
 
-	_SPI_NAND_READ_CHIP_SELECT_HIGH();
+	ptr_rtn_flash_id->mfr_id = id[1];
+	ptr_rtn_flash_id->dev_id = id[2];
 	return SPI_NAND_FLASH_RTN_NO_ERROR;
-
-spi_fail:
-	_SPI_NAND_READ_CHIP_SELECT_HIGH();
-	return SPI_NAND_FLASH_RTN_SPI_CTRL_FAIL;
 }
 
 /* Page read */
@@ -307,15 +253,24 @@ SPI_NAND_FLASH_RTN_T spi_nand_protocol_page_read(u32 page_number)
 	u8 cmd[4];
 	SPI_CONTROLLER_RTN_T spi_ret;
 
-	_SPI_NAND_READ_CHIP_SELECT_LOW();
-
 	cmd[0] = _SPI_NAND_OP_PAGE_READ;
 	cmd[1] = (page_number >> 16) & 0xff;
 	cmd[2] = (page_number >> 8) & 0xff;
 	cmd[3] = (page_number) & 0xff;
-	spi_ret = _SPI_NAND_WRITE_NBYTE(cmd, 4, SPI_CONTROLLER_SPEED_SINGLE);
+	spi_ret = _SPI_NAND_TRANSACTION(cmd, sizeof(cmd), NULL, 0);
+
+	return (spi_ret == SPI_CONTROLLER_RTN_NO_ERROR) ? SPI_NAND_FLASH_RTN_NO_ERROR : SPI_NAND_FLASH_RTN_SPI_CTRL_FAIL;
+}
+
+/* Sequential cache read: 0x31 hands over the page loaded before and starts
+ * loading the next one, 0x3F hands over the last page without loading more */
+SPI_NAND_FLASH_RTN_T spi_nand_protocol_page_read_cache(bool last)
+{
+	u8 cmd = last ? _SPI_NAND_OP_PAGE_READ_CACHE_LAST : _SPI_NAND_OP_PAGE_READ_CACHE_SEQ;
+	SPI_CONTROLLER_RTN_T spi_ret;
+
+	spi_ret = _SPI_NAND_TRANSACTION(&cmd, 1, NULL, 0);
 
-	_SPI_NAND_READ_CHIP_SELECT_HIGH();
 	return (spi_ret == SPI_CONTROLLER_RTN_NO_ERROR) ? SPI_NAND_FLASH_RTN_NO_ERROR : SPI_NAND_FLASH_RTN_SPI_CTRL_FAIL;
 }
 
@@ -325,19 +280,14 @@ SPI_NAND_FLASH_RTN_T spi_nand_protocol_read_from_cache(u32 data_offset, u32 len,
 {
 	struct SPI_NAND_FLASH_INFO_T *ptr_dev_info_t = _SPI_NAND_GET_DEVICE_INFO_PTR;
 	SPI_CONTROLLER_RTN_T spi_ret;
+	u8 cmd[6];
+	u32 n = 0;
 	u8 addr_high, addr_low;
 
-	_SPI_NAND_READ_CHIP_SELECT_LOW();
-	spi_ret = _SPI_NAND_WRITE_ONE_BYTE(_SPI_NAND_OP_READ_FROM_CACHE_SINGLE);
-	if (spi_ret != SPI_CONTROLLER_RTN_NO_ERROR)
-		goto spi_fail;
+	cmd[n++] = _SPI_NAND_OP_READ_FROM_CACHE_SINGLE;
 
 	if (dummy_mode == SPI_NAND_FLASH_READ_DUMMY_BYTE_PREPEND)
-	{
-		spi_ret = _SPI_NAND_WRITE_ONE_BYTE(0xff); /* dummy byte */
-		if (spi_ret != SPI_CONTROLLER_RTN_NO_ERROR)
-			goto spi_fail;
-	}
+		cmd[n++] = 0xff; /* dummy byte */
 
 	if (((ptr_dev_info_t->feature) & SPI_NAND_FLASH_PLANE_SELECT_HAVE))
 	{
@@ -356,65 +306,44 @@ SPI_NAND_FLASH_RTN_T spi_nand_protocol_read_from_cache(u32 data_offset, u32 len,
 	}
 	addr_low = ((data_offset) & (0xff));
 
-	spi_ret = _SPI_NAND_WRITE_ONE_BYTE(addr_high);
-	if (spi_ret != SPI_CONTROLLER_RTN_NO_ERROR)
-		goto spi_fail;
-	spi_ret = _SPI_NAND_WRITE_ONE_BYTE(addr_low);
-	if (spi_ret != SPI_CONTROLLER_RTN_NO_ERROR)
-		goto spi_fail;
+	cmd[n++] = addr_high;
+	cmd[n++] = addr_low;
 
 	if (dummy_mode == SPI_NAND_FLASH_READ_DUMMY_BYTE_APPEND)
-	{
-		spi_ret = _SPI_NAND_WRITE_ONE_BYTE(0xff); /* dummy byte */
-		if (spi_ret != SPI_CONTROLLER_RTN_NO_ERROR)
-			goto spi_fail;
-	}
+		cmd[n++] = 0xff; /* dummy byte */
 
 	if (dummy_mode == SPI_NAND_FLASH_READ_DUMMY_BYTE_PREPEND &&
 	    ((read_mode == SPI_NAND_FLASH_READ_SPEED_MODE_DUAL) || (read_mode == SPI_NAND_FLASH_READ_SPEED_MODE_QUAD)))
-	{
-		spi_ret = _SPI_NAND_WRITE_ONE_BYTE(0xff); /* for dual/quad read dummy byte */
-		if (spi_ret != SPI_CONTROLLER_RTN_NO_ERROR)
-			goto spi_fail;
-	}
-
-	switch (read_mode)
-	{
-	case SPI_NAND_FLASH_READ_SPEED_MODE_SINGLE:
-		spi_ret = _SPI_NAND_READ_NBYTE(ptr_rtn_buf, len, SPI_CONTROLLER_SPEED_SINGLE);
-		break;
-	case SPI_NAND_FLASH_READ_SPEED_MODE_DUAL:
-		spi_ret = _SPI_NAND_READ_NBYTE(ptr_rtn_buf, len, SPI_CONTROLLER_SPEED_DUAL);
-		break;
-	case SPI_NAND_FLASH_READ_SPEED_MODE_QUAD:
-		spi_ret = _SPI_NAND_READ_NBYTE(ptr_rtn_buf, len, SPI_CONTROLLER_SPEED_QUAD);
-		break;
-	default:
-		spi_ret = SPI_CONTROLLER_RTN_NO_ERROR; // Or perhaps an error for invalid mode?
-		break;
+		cmd[n++] = 0xff; /* for dual/quad read dummy byte */
+
+	/* Unknown speed modes issue the command but transfer no data */
+	if (read_mode >= SPI_NAND_FLASH_READ_SPEED_MODE_DEF_NO)
+		len = 0;
+
+	/* Dual chips try the 0x3B data phase first, single-bit if unavailable */
+	spi_ret = SPI_CONTROLLER_RTN_NOT_SUPPORTED;
+	if (read_mode == SPI_NAND_FLASH_READ_SPEED_MODE_DUAL && len) {
+		cmd[0] = _SPI_NAND_OP_READ_FROM_CACHE_DUAL;
+		spi_ret = _SPI_NAND_READ_DUAL(cmd, n, _SPI_NAND_OP_READ_FROM_CACHE_SINGLE, ptr_rtn_buf, len);
+		cmd[0] = _SPI_NAND_OP_READ_FROM_CACHE_SINGLE;
 	}
-	if (spi_ret != SPI_CONTROLLER_RTN_NO_ERROR)
-		goto spi_fail;
-
-	_SPI_NAND_READ_CHIP_SELECT_HIGH();
-	return SPI_NAND_FLASH_RTN_NO_ERROR;
-
-spi_fail:
-	_SPI_NAND_READ_CHIP_SELECT_HIGH();
-	return SPI_NAND_FLASH_RTN_SPI_CTRL_FAIL;
+	if (spi_ret == SPI_CONTROLLER_RTN_NOT_SUPPORTED)
+		spi_ret = _SPI_NAND_TRANSACTION(cmd, n, ptr_rtn_buf, len);
+	return (spi_ret == SPI_CONTROLLER_RTN_NO_ERROR) ? SPI_NAND_FLASH_RTN_NO_ERROR : SPI_NAND_FLASH_RTN_SPI_CTRL_FAIL;
 }
 
-/* Program load */
-SPI_NAND_FLASH_RTN_T spi_nand_protocol_program_load(u32 addr, u8 *ptr_data, u32 len, u32 write_mode)
+/* Program load with the given opcode: 0x02 resets the whole cache to 0xFF
+ * first, 0x84 (random) overwrites only the bytes sent */
+static SPI_NAND_FLASH_RTN_T spi_nand_protocol_load_cache(u8 op, u32 addr, u8 *ptr_data, u32 len, u32 write_mode)
 {
+	/* Opcode, column address and data are sent in one CS cycle */
+	static u8 cmd[3 + _SPI_NAND_CACHE_SIZE];
 	struct SPI_NAND_FLASH_INFO_T *ptr_dev_info_t = _SPI_NAND_GET_DEVICE_INFO_PTR;
 	SPI_CONTROLLER_RTN_T spi_ret;
 	u8 addr_high, addr_low;
 
-	_SPI_NAND_READ_CHIP_SELECT_LOW();
-	spi_ret = _SPI_NAND_WRITE_ONE_BYTE(_SPI_NAND_OP_PROGRAM_LOAD_SINGLE);
-	if (spi_ret != SPI_CONTROLLER_RTN_NO_ERROR)
-		goto spi_fail;
+	if (len > _SPI_NAND_CACHE_SIZE)
+		return SPI_NAND_FLASH_RTN_SPI_CTRL_FAIL;
 
 	if (((ptr_dev_info_t->feature) & SPI_NAND_FLASH_PLANE_SELECT_HAVE))
 	{
@@ -433,80 +362,55 @@ SPI_NAND_FLASH_RTN_T spi_nand_protocol_program_load(u32 addr, u8 *ptr_data, u32
 	}
 	addr_low = ((addr) & (0xff));
 
-	spi_ret = _SPI_NAND_WRITE_ONE_BYTE(addr_high);
-	if (spi_ret != SPI_CONTROLLER_RTN_NO_ERROR)
-		goto spi_fail;
-	spi_ret = _SPI_NAND_WRITE_ONE_BYTE(addr_low);
-	if (spi_ret != SPI_CONTROLLER_RTN_NO_ERROR)
-		goto spi_fail;
+	/* Unknown speed modes issue the command but transfer no data */
+	if (write_mode >= SPI_NAND_FLASH_WRITE_SPEED_MODE_DEF_NO)
+		len = 0;
 
-	switch (write_mode)
-	{
-	case SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE:
-		spi_ret = _SPI_NAND_WRITE_NBYTE(ptr_data, len, SPI_CONTROLLER_SPEED_SINGLE);
-		break;
-	case SPI_NAND_FLASH_WRITE_SPEED_MODE_QUAD:
-		spi_ret = _SPI_NAND_WRITE_NBYTE(ptr_data, len, SPI_CONTROLLER_SPEED_QUAD);
-		break;
-	default:
-		spi_ret = SPI_CONTROLLER_RTN_NO_ERROR; // Or perhaps an error for invalid mode?
-		break;
-	}
-	if (spi_ret != SPI_CONTROLLER_RTN_NO_ERROR)
-		goto spi_fail;
+	cmd[0] = op;
+	cmd[1] = addr_high;
+	cmd[2] = addr_low;
+	memcpy(&cmd[3], ptr_data, len);
 
-	_SPI_NAND_READ_CHIP_SELECT_HIGH();
-	return SPI_NAND_FLASH_RTN_NO_ERROR;
+	spi_ret = _SPI_NAND_TRANSACTION(cmd, 3 + len, NULL, 0);
+	return (spi_ret == SPI_CONTROLLER_RTN_NO_ERROR) ? SPI_NAND_FLASH_RTN_NO_ERROR : SPI_NAND_FLASH_RTN_SPI_CTRL_FAIL;
+}
 
-spi_fail:
-	_SPI_NAND_READ_CHIP_SELECT_HIGH();
-	return SPI_NAND_FLASH_RTN_SPI_CTRL_FAIL;
+/* Program load */
+SPI_NAND_FLASH_RTN_T spi_nand_protocol_program_load(u32 addr, u8 *ptr_data, u32 len, u32 write_mode)
+{
+	return spi_nand_protocol_load_cache(_SPI_NAND_OP_PROGRAM_LOAD_SINGLE, addr, ptr_data, len, write_mode);
+}
+
+/* Random program load: patch len bytes at addr into the page already in the
+ * cache, leaving the rest of it as Page Read or earlier loads left it */
+SPI_NAND_FLASH_RTN_T spi_nand_protocol_program_load_random(u32 addr, u8 *ptr_data, u32 len, u32 write_mode)
+{
+	return spi_nand_protocol_load_cache(_SPI_NAND_OP_PROGRAM_LOAD_RAMDOM_SINGLE, addr, ptr_data, len, write_mode);
 }
 
 /* Program execute */
 SPI_NAND_FLASH_RTN_T spi_nand_protocol_program_execute(u32 addr)
 {
+	u8 cmd[4];
 	SPI_CONTROLLER_RTN_T spi_ret;
-	_SPI_NAND_READ_CHIP_SELECT_LOW();
-	spi_ret = _SPI_NAND_WRITE_ONE_BYTE(_SPI_NAND_OP_PROGRAM_EXECUTE);
-	if (spi_ret != SPI_CONTROLLER_RTN_NO_ERROR)
-		goto spi_fail;
-
-	spi_ret = _SPI_NAND_WRITE_ONE_BYTE(((addr >> 16) & 0xff));
-	if (spi_ret != SPI_CONTROLLER_RTN_NO_ERROR)
-		goto spi_fail;
-	spi_ret = _SPI_NAND_WRITE_ONE_BYTE(((addr >> 8) & 0xff));
-	if (spi_ret != SPI_CONTROLLER_RTN_NO_ERROR)
-		goto spi_fail;
-	spi_ret = _SPI_NAND_WRITE_ONE_BYTE(((addr) & 0xff));
-	if (spi_ret != SPI_CONTROLLER_RTN_NO_ERROR)
-		goto spi_fail;
 
-	_SPI_NAND_READ_CHIP_SELECT_HIGH();
-	return SPI_NAND_FLASH_RTN_NO_ERROR;
+	cmd[0] = _SPI_NAND_OP_PROGRAM_EXECUTE;
+	cmd[1] = (addr >> 16) & 0xff;
+	cmd[2] = (addr >> 8) & 0xff;
+	cmd[3] = addr & 0xff;
 
-spi_fail:
-	_SPI_NAND_READ_CHIP_SELECT_HIGH();
-	return SPI_NAND_FLASH_RTN_SPI_CTRL_FAIL;
+	spi_ret = _SPI_NAND_TRANSACTION(cmd, sizeof(cmd), NULL, 0);
+	return (spi_ret == SPI_CONTROLLER_RTN_NO_ERROR) ? SPI_NAND_FLASH_RTN_NO_ERROR : SPI_NAND_FLASH_RTN_SPI_CTRL_FAIL;
 }
 
 /* Die select methods */
 SPI_NAND_FLASH_RTN_T spi_nand_protocol_die_select_1(u8 die_id)
 {
+	u8 cmd[2] = { _SPI_NAND_OP_DIE_SELECT, die_id };
 	SPI_CONTROLLER_RTN_T spi_ret;
-	_SPI_NAND_READ_CHIP_SELECT_LOW();
-	spi_ret = _SPI_NAND_WRITE_ONE_BYTE(_SPI_NAND_OP_DIE_SELECT);
-	if (spi_ret != SPI_CONTROLLER_RTN_NO_ERROR)
-		goto spi_fail;
-	spi_ret = _SPI_NAND_WRITE_ONE_BYTE(die_id);
-	if (spi_ret != SPI_CONTROLLER_RTN_NO_ERROR)
-		goto spi_fail;
-	_SPI_NAND_READ_CHIP_SELECT_HIGH();
-	return SPI_NAND_FLASH_RTN_NO_ERROR;
 
-spi_fail:
-	_SPI_NAND_READ_CHIP_SELECT_HIGH();
-	return SPI_NAND_FLASH_RTN_SPI_CTRL_FAIL;
+	spi_ret = _SPI_NAND_TRANSACTION(cmd, sizeof(cmd), NULL, 0);
+	return (spi_ret == SPI_CONTROLLER_RTN_NO_ERROR) ? SPI_NAND_FLASH_RTN_NO_ERROR : SPI_NAND_FLASH_RTN_SPI_CTRL_FAIL;
 }
 
 SPI_NAND_FLASH_RTN_T spi_nand_protocol_die_select_2(u8 die_id)
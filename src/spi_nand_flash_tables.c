@@ -375,7 +375,7 @@ const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 	    .dummy_mode = SPI_NAND_FLASH_READ_DUMMY_BYTE_APPEND,
 	    .read_mode = SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 	    .write_mode = SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
-	    .feature = SPI_NAND_FLASH_FEATURE_NONE,
+	    .feature = SPI_NAND_FLASH_CONT_READ_HAVE,
     },
 
     {
@@ -390,7 +390,7 @@ const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 	    .dummy_mode = SPI_NAND_FLASH_READ_DUMMY_BYTE_APPEND,
 	    .read_mode = SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 	    .write_mode = SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
-	    .feature = SPI_NAND_FLASH_FEATURE_NONE,
+	    .feature = SPI_NAND_FLASH_CONT_READ_HAVE,
     },
 
     {
@@ -405,7 +405,7 @@ const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 	    .dummy_mode = SPI_NAND_FLASH_READ_DUMMY_BYTE_APPEND,
 	    .read_mode = SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 	    .write_mode = SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
-	    .feature = SPI_NAND_FLASH_FEATURE_NONE,
+	    .feature = SPI_NAND_FLASH_CONT_READ_HAVE,
     },
 
     {
@@ -420,7 +420,7 @@ const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 	    .dummy_mode = SPI_NAND_FLASH_READ_DUMMY_BYTE_APPEND,
 	    .read_mode = SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 	    .write_mode = SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
-	    .feature = SPI_NAND_FLASH_FEATURE_NONE,
+	    .feature = SPI_NAND_FLASH_CONT_READ_HAVE,
     },
 
     {
@@ -435,7 +435,7 @@ const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 	    .dummy_mode = SPI_NAND_FLASH_READ_DUMMY_BYTE_APPEND,
 	    .read_mode = SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 	    .write_mode = SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
-	    .feature = SPI_NAND_FLASH_FEATURE_NONE,
+	    .feature = SPI_NAND_FLASH_CONT_READ_HAVE,
     },
 
     {
@@ -450,7 +450,7 @@ const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 	    .dummy_mode = SPI_NAND_FLASH_READ_DUMMY_BYTE_APPEND,
 	    .read_mode = SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 	    .write_mode = SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
-	    .feature = SPI_NAND_FLASH_FEATURE_NONE,
+	    .feature = SPI_NAND_FLASH_CONT_READ_HAVE,
     },
 
     {
@@ -465,7 +465,7 @@ const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 	    .dummy_mode = SPI_NAND_FLASH_READ_DUMMY_BYTE_APPEND,
 	    .read_mode = SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 	    .write_mode = SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
-	    .feature = SPI_NAND_FLASH_DIE_SELECT_1_HAVE,
+	    .feature = SPI_NAND_FLASH_DIE_SELECT_1_HAVE | SPI_NAND_FLASH_CONT_READ_HAVE,
     },
 
     {
@@ -1021,7 +1021,7 @@ const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 	    .dummy_mode = SPI_NAND_FLASH_READ_DUMMY_BYTE_APPEND,
 	    .read_mode = SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 	    .write_mode = SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
-	    .feature = SPI_NAND_FLASH_FEATURE_NONE,
+	    .feature = SPI_NAND_FLASH_CACHE_READ_HAVE,
     },
 
     {
@@ -1035,7 +1035,7 @@ const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 	    .dummy_mode = SPI_NAND_FLASH_READ_DUMMY_BYTE_APPEND,
 	    .read_mode = SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 	    .write_mode = SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
-	    .feature = SPI_NAND_FLASH_PLANE_SELECT_HAVE,
+	    .feature = SPI_NAND_FLASH_PLANE_SELECT_HAVE | SPI_NAND_FLASH_CACHE_READ_HAVE,
     },
 
     {
@@ -1049,7 +1049,7 @@ const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 	    .dummy_mode = SPI_NAND_FLASH_READ_DUMMY_BYTE_APPEND,
 	    .read_mode = SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 	    .write_mode = SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
-	    .feature = SPI_NAND_FLASH_PLANE_SELECT_HAVE,
+	    .feature = SPI_NAND_FLASH_PLANE_SELECT_HAVE | SPI_NAND_FLASH_CACHE_READ_HAVE,
     },
 
     {
@@ -1063,7 +1063,7 @@ const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 	    .dummy_mode = SPI_NAND_FLASH_READ_DUMMY_BYTE_APPEND,
 	    .read_mode = SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 	    .write_mode = SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
-	    .feature = SPI_NAND_FLASH_FEATURE_NONE,
+	    .feature = SPI_NAND_FLASH_CACHE_READ_HAVE,
     },
 
     {
@@ -1077,7 +1077,7 @@ const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 	    .dummy_mode = SPI_NAND_FLASH_READ_DUMMY_BYTE_APPEND,
 	    .read_mode = SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 	    .write_mode = SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
-	    .feature = SPI_NAND_FLASH_FEATURE_NONE,
+	    .feature = SPI_NAND_FLASH_CACHE_READ_HAVE,
     },
 
     {
@@ -1091,7 +1091,7 @@ const struct SPI_NAND_FLASH_INFO_T spi_nand_flash_tables[] = {
 	    .dummy_mode = SPI_NAND_FLASH_READ_DUMMY_BYTE_APPEND,
 	    .read_mode = SPI_NAND_FLASH_READ_SPEED_MODE_DUAL,
 	    .write_mode = SPI_NAND_FLASH_WRITE_SPEED_MODE_SINGLE,
-	    .feature = SPI_NAND_FLASH_DIE_SELECT_2_HAVE,
+	    .feature = SPI_NAND_FLASH_DIE_SELECT_2_HAVE | SPI_NAND_FLASH_CACHE_READ_HAVE,
     },
 
     {
@@ -4,16 +4,20 @@
 #include "types.h"
 #include "timer.h"
 #include "ch341a_spi.h"
+#include "chipdb.h"
+#include "snor_index.h"
 #include <stdio.h>
 #include <stddef.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <string.h>
+#include <time.h>
 
 extern int debug_enabled;
 
 // Global variable definitions
 struct chip_info *spi_chip_info = NULL;
+struct snor_caps snor_caps;
 static bool last_wait_error_was_epe = false;
 struct snor_progress_state {
 	const char *op;
@@ -31,6 +35,35 @@ static void snor_clear_progress(void)
 {
 	snor_set_progress("IDLE", 0);
 }
+
+/* Shadow of chip state that only our own commands change, valid for the
+ * session started by snor_init(). It lets unprotect and 4-byte entry run
+ * once per operation instead of once per page or sector. */
+static struct {
+	bool sr2_valid;    /* sr2/sr3 below match the chip */
+	bool sr3_valid;
+	u8 sr2;
+	u8 sr3;
+	bool unprotected;  /* snor_unprotect() cleared all protection */
+	bool wel;          /* a WREN may still be latched */
+	int addr4b;        /* addressing mode the chip is in, -1 if unknown */
+	int addr4b_depth;  /* nesting of snor_addr_mode_begin() */
+} snor_shadow = { false, false, 0, 0, false, true, -1, 0 };
+
+static void snor_shadow_reset(void)
+{
+	memset(&snor_shadow, 0, sizeof(snor_shadow));
+	snor_shadow.wel = true;
+	snor_shadow.addr4b = -1;
+}
+
+/* A status register write or reset: re-read before trusting the shadow */
+static void snor_shadow_invalidate_sr(void)
+{
+	snor_shadow.sr2_valid = false;
+	snor_shadow.sr3_valid = false;
+	snor_shadow.unprotected = false;
+}
 // unsigned int bsize = 0; // Defined in spi_nand_flash.c
 
 
@@ -54,15 +87,65 @@ static bool snor_is_normem(void)
 	return strncmp(spi_chip_info->name, "NM", 2) == 0;
 }
 
+/* Single-byte command in its own CS cycle */
+static int snor_cmd(u8 code)
+{
+	return SPI_CONTROLLER_Transaction(&code, 1, NULL, 0);
+}
+
+/* The chip takes the dedicated 4-byte opcodes; set from the chip table or
+ * the SFDP 4-byte address instruction table */
+static bool snor_addr4b_opcodes = false;
+
+/* 4-byte-address form of an address-taking opcode, 0 if it has none */
+static u8 snor_opcode4b(u8 code)
+{
+	switch (code) {
+	case OPCODE_READ:      return OPCODE_READ4B;
+	case OPCODE_FAST_READ: return OPCODE_FAST_READ4B;
+	case OPCODE_DOR:       return OPCODE_DOR4B;
+	case OPCODE_PP:        return OPCODE_PP4B;
+	case OPCODE_SE:        return OPCODE_SE4B;
+	case OPCODE_P4E:       return OPCODE_P4E4B;
+	case OPCODE_BE32:      return OPCODE_BE32_4B;
+	}
+	return 0;
+}
+
+/* Map an address-taking opcode to its 4-byte form on chips that have one */
+static u8 snor_opcode(u8 code)
+{
+	u8 code4b;
+
+	if (!snor_addr4b_opcodes || !(code4b = snor_opcode4b(code)))
+		return code;
+	return code4b;
+}
+
+/* Opcode followed by a 3- or 4-byte address, per the chip's addressing mode */
+static unsigned int snor_fill_cmd(u8 *cmd, u8 code, unsigned long addr)
+{
+	unsigned int n = 0;
+
+	cmd[n++] = snor_opcode(code);
+	if (spi_chip_info->addr4b)
+		cmd[n++] = (addr >> 24) & 0xff;
+	cmd[n++] = (addr >> 16) & 0xff;
+	cmd[n++] = (addr >> 8) & 0xff;
+	cmd[n++] = addr & 0xff;
+	return n;
+}
+
 static int snor_write_status_block(const u8 *vals, size_t len)
 {
 	int retval;
+	u8 cmd[3];
 	if (!len || len > 2)
 		return -1;
-	SPI_CONTROLLER_Chip_Select_Low();
-	SPI_CONTROLLER_Write_One_Byte(OPCODE_WRSR);
-	retval = SPI_CONTROLLER_Write_NByte((u8 *)vals, len);
-	SPI_CONTROLLER_Chip_Select_High();
+	cmd[0] = OPCODE_WRSR;
+	memcpy(&cmd[1], vals, len);
+	snor_shadow_invalidate_sr();
+	retval = SPI_CONTROLLER_Transaction(cmd, 1 + len, NULL, 0);
 	if (retval) {
 		printf("%s: ret: %x\n", __func__, retval);
 		return -1;
@@ -72,25 +155,74 @@ static int snor_write_status_block(const u8 *vals, size_t len)
 
 static void snor_clear_status(void)
 {
-	SPI_CONTROLLER_Chip_Select_Low();
-	SPI_CONTROLLER_Write_One_Byte(OPCODE_CLSR);
-	SPI_CONTROLLER_Chip_Select_High();
+	snor_cmd(OPCODE_CLSR);
+}
+
+/* snor_wait_ready() budget for an operation: the chip's own worst case
+ * where SFDP gave one, never below the historical default */
+#define SNOR_WAIT_MAX_MS 1000000
+
+static int snor_wait_budget(u32 max_ms, int dflt)
+{
+	if (max_ms > SNOR_WAIT_MAX_MS)
+		max_ms = SNOR_WAIT_MAX_MS;
+	return (int)max_ms > dflt ? (int)max_ms : dflt;
+}
+
+/* Erase type that clears one spi_chip_info->sector_size sector */
+static struct snor_erase_type snor_sector_erase(void)
+{
+	struct snor_erase_type et = { spi_chip_info->sector_size, OPCODE_SE, 0, 0 };
+	int i;
+
+	for (i = 0; i < snor_caps.n_erase; i++)
+		if (snor_caps.erase[i].size == spi_chip_info->sector_size)
+			return snor_caps.erase[i];
+	return et;
+}
+
+/* Status samples taken per poll, one USB round trip on programmers that can
+ * repeat a command. The web build keeps one sample per 100 ms sleep. */
+#ifdef __EMSCRIPTEN__
+#define SNOR_POLL_SAMPLES 1
+#else
+#define SNOR_POLL_SAMPLES 8
+#endif
+
+/* Read SR until it shows ready or SNOR_POLL_SAMPLES samples have been taken.
+ * Returns the number of samples consumed, or -1 on error. */
+static int snor_poll_sr(u8 *sr)
+{
+	u8 code = OPCODE_RDSR;
+	u32 idx;
+	int retval;
+
+	retval = SPI_CONTROLLER_Read_Status(sr);
+	if (retval != SPI_CONTROLLER_RTN_NOT_SUPPORTED)
+		return retval ? -1 : 1;
+
+	retval = SPI_CONTROLLER_Poll_Status(&code, 1, SR_WIP | SR_EPE | SR_WEL, SNOR_POLL_SAMPLES, sr, &idx);
+	if (retval) {
+		printf("%s: ret: %x\n", __func__, retval);
+		return -1;
+	}
+	return idx < SNOR_POLL_SAMPLES ? (int)idx + 1 : SNOR_POLL_SAMPLES;
 }
 
 // Function implementations
 int snor_wait_ready(int sleep_ms) {
-    int count;
+    int count, n;
     u8 sr = 0;
     last_wait_error_was_epe = false;
 #ifdef __EMSCRIPTEN__
     if (sleep_ms < 100) {
         usleep(sleep_ms > 0 ? sleep_ms * 1000 : 1000);
     }
-    for (count = 0; count < (sleep_ms < 100 ? 10 : sleep_ms * 5 + 5); count++) {
+    for (count = 0; count < (sleep_ms < 100 ? 10 : sleep_ms * 5 + 5); count += n) {
 #else
-    for (count = 0; count < ((sleep_ms + 1) * 1000); count++) {
+    for (count = 0; count < ((sleep_ms + 1) * 1000); count += n) {
 #endif
-		if ((snor_read_sr(&sr)) < 0)
+		if ((n = snor_poll_sr(&sr)) < 0)
 			break;
 		if (sr & SR_EPE) {
 			last_wait_error_was_epe = true;
@@ -100,6 +232,7 @@ int snor_wait_ready(int sleep_ms) {
 			return -1;
 		}
 		if (!(sr & (SR_WIP | SR_EPE | SR_WEL))) {
+            snor_shadow.wel = false;
             return 0;
         }
 #ifdef __EMSCRIPTEN__
@@ -113,9 +246,189 @@ int snor_wait_ready(int sleep_ms) {
     return -1;
 }
 
-static int snor_wait_ready_retry_epe(int sleep_ms)
+/*
+ * Busy-time model per operation kind: seeded from SFDP typical and maximum
+ * times or datasheet-typical figures, then moved toward the completions
+ * measured in this session. snor_wait_op() sleeps through most of the
+ * expected time before its first status read and backs off from there, never
+ * more than SNOR_WAIT_GAP_MAX_US between reads, so a long erase still ends
+ * as soon as the chip does.
+ */
+enum {
+	SNOR_OP_NONE = -1,
+	SNOR_OP_PP,
+	SNOR_OP_WRSR,
+	SNOR_OP_BE,
+	SNOR_OP_SE,        /* sector erase outside the known erase types */
+	SNOR_OP_ERASE,     /* + index into snor_caps.erase */
+	SNOR_OP_COUNT = SNOR_OP_ERASE + SNOR_ERASE_TYPES
+};
+
+struct snor_timing {
+	u64 seed_us;       /* starting estimate */
+	u64 est_us;        /* current estimate of the busy time */
+	u64 max_us;        /* worst case, 0 if unknown */
+	unsigned long n;   /* completions measured */
+	u64 total_us;
+	u64 min_us;
+	u64 peak_us;
+	unsigned long polls;
+};
+static struct snor_timing snor_timing[SNOR_OP_COUNT];
+
+#define SNOR_WAIT_FIRST_PCT 90   /* of the estimate, slept before polling */
+#define SNOR_WAIT_GAP_MIN_US 50
+#define SNOR_WAIT_GAP_MAX_US 100000
+
+/* Datasheet-typical busy time for an erase of this size, when SFDP is mute */
+static u64 snor_erase_typ_us(unsigned long size)
 {
-	int ret = snor_wait_ready(sleep_ms);
+	if (size <= 0x1000)
+		return 45000;
+	if (size <= 0x8000)
+		return 120000;
+	return 150000ULL * (size / 0x10000);
+}
+
+static void snor_timing_seed(int op, u64 typ_us, u64 max_us)
+{
+	memset(&snor_timing[op], 0, sizeof(snor_timing[op]));
+	snor_timing[op].seed_us = typ_us;
+	snor_timing[op].est_us = typ_us;
+	snor_timing[op].max_us = max_us;
+}
+
+static void snor_timing_init(void)
+{
+	int i;
+
+	snor_timing_seed(SNOR_OP_PP, snor_caps.page_typ_us ? snor_caps.page_typ_us : 700,
+			 snor_caps.page_max_us ? snor_caps.page_max_us : 3000);
+	snor_timing_seed(SNOR_OP_WRSR, 10000, 15000);
+	snor_timing_seed(SNOR_OP_BE, snor_caps.chip_typ_ms ? snor_caps.chip_typ_ms * 1000ULL :
+			 snor_erase_typ_us(0x10000) * (snor_caps.size / 0x10000),
+			 snor_caps.chip_max_ms * 1000ULL);
+	snor_timing_seed(SNOR_OP_SE, snor_erase_typ_us(spi_chip_info->sector_size), 0);
+	for (i = 0; i < SNOR_ERASE_TYPES; i++)
+		snor_timing_seed(SNOR_OP_ERASE + i,
+				 snor_caps.erase[i].typ_ms ? snor_caps.erase[i].typ_ms * 1000ULL :
+				 snor_erase_typ_us(snor_caps.erase[i].size),
+				 snor_caps.erase[i].max_ms * 1000ULL);
+}
+
+static const char *snor_timing_name(int op, char *buf, size_t len)
+{
+	static const char *names[] = { "PP", "WRSR", "BE", "SE" };
+
+	if (op < SNOR_OP_ERASE)
+		return names[op];
+	snprintf(buf, len, "%uK erase", snor_caps.erase[op - SNOR_OP_ERASE].size >> 10);
+	return buf;
+}
+
+/* Print the model and what this session measured, under --debug */
+static void snor_timing_report(void)
+{
+	char name[16];
+	int op;
+
+	if (!debug_enabled)
+		return;
+	for (op = 0; op < SNOR_OP_COUNT; op++) {
+		struct snor_timing *t = &snor_timing[op];
+		if (!t->n)
+			continue;
+		fprintf(stderr, "[DEBUG] NOR timing: %-9s model %llu us (seed %llu, max %llu), "
+			"%lu done, avg %llu us, min %llu, peak %llu, %.1f polls each\n",
+			snor_timing_name(op, name, sizeof(name)), t->est_us, t->seed_us, t->max_us,
+			t->n, t->total_us / t->n, t->min_us, t->peak_us, (double)t->polls / t->n);
+	}
+}
+
+static u64 snor_now_us(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+/* Fold a measured completion into the model: the first one moves the seed
+ * half way, later ones move the estimate a quarter of the way, so a single
+ * odd completion can't set every later wait */
+static void snor_timing_record(struct snor_timing *t, u64 us)
+{
+	t->est_us = t->n ? (3 * t->est_us + us) / 4 : (t->est_us + us) / 2;
+	if (!t->n || us < t->min_us)
+		t->min_us = us;
+	if (us > t->peak_us)
+		t->peak_us = us;
+	t->total_us += us;
+	t->n++;
+}
+
+/* Wait for an operation of the given kind that was just issued. sleep_ms is
+ * the historical snor_wait_ready() budget, kept as a floor for the deadline. */
+static int snor_wait_op(int op, int sleep_ms)
+{
+	struct snor_timing *t = &snor_timing[op];
+	int budget_ms = snor_wait_budget((u32)min(t->max_us / 1000, (u64)SNOR_WAIT_MAX_MS), sleep_ms);
+	u64 start = snor_now_us();
+#ifdef __EMSCRIPTEN__
+	/* The web build keeps its fixed 100 ms polling, measured all the same */
+	if (snor_wait_ready(budget_ms))
+		return -1;
+	snor_timing_record(t, snor_now_us() - start);
+	return 0;
+#else
+	u64 deadline, gap, gap_max, first;
+	u8 sr = 0;
+
+	last_wait_error_was_epe = false;
+	/* Twice the worst case or the old budget, four times the estimate if
+	 * that is longer, plus a second of slack for USB */
+	deadline = (u64)budget_ms * 2000 > t->est_us * 4 ? (u64)budget_ms * 2000 : t->est_us * 4;
+	deadline += start + 1000000ULL;
+
+	gap = t->est_us / 16 > SNOR_WAIT_GAP_MIN_US ? t->est_us / 16 : SNOR_WAIT_GAP_MIN_US;
+	gap_max = t->est_us / 4 > gap ? t->est_us / 4 : gap;
+	if (gap_max > SNOR_WAIT_GAP_MAX_US)
+		gap_max = SNOR_WAIT_GAP_MAX_US;
+	if (gap > gap_max)
+		gap = gap_max;
+	/* Longer first sleeps are cut into gap_max slices by the loop below */
+	first = t->est_us * SNOR_WAIT_FIRST_PCT / 100;
+	if (first >= SNOR_WAIT_GAP_MIN_US)
+		usleep(first < gap_max ? first : gap_max);
+
+	for (;;) {
+		if (snor_poll_sr(&sr) < 0)
+			break;
+		t->polls++;
+		if (sr & SR_EPE) {
+			last_wait_error_was_epe = true;
+			snor_log_status("snor_wait_op", sr);
+			printf("%s: erase/program error (SR=%02x)\n", __func__, sr);
+			snor_clear_status();
+			return -1;
+		}
+		if (!(sr & (SR_WIP | SR_EPE | SR_WEL))) {
+			snor_timing_record(t, snor_now_us() - start);
+			snor_shadow.wel = false;
+			return 0;
+		}
+		if (snor_now_us() >= deadline)
+			break;
+		usleep(gap);
+		gap = gap * 2 < gap_max ? gap * 2 : gap_max;
+	}
+	printf("%s: read_sr fail: %x\n", __func__, sr);
+	return -1;
+#endif
+}
+
+static int snor_wait_op_retry_epe(int op, int sleep_ms)
+{
+	int ret = op == SNOR_OP_NONE ? snor_wait_ready(sleep_ms) : snor_wait_op(op, sleep_ms);
 	if (!ret)
 		return 0;
 	if (debug_enabled)
@@ -125,13 +438,18 @@ static int snor_wait_ready_retry_epe(int sleep_ms)
 		return -1;
 	if (debug_enabled)
 		fprintf(stderr, "[DEBUG] snor_wait_ready_retry_epe: retrying after SR_EPE (sleep=%dms)\n", sleep_ms);
-	ret = snor_wait_ready(sleep_ms);
+	ret = op == SNOR_OP_NONE ? snor_wait_ready(sleep_ms) : snor_wait_op(op, sleep_ms);
 	if (ret && debug_enabled)
 		fprintf(stderr, "[DEBUG] snor_wait_ready_retry_epe: retry failed (op=%s addr=0x%08lx epe=%d)\n",
 			snor_progress.op, snor_progress.addr, last_wait_error_was_epe);
 	return ret;
 }
 
+static int snor_wait_ready_retry_epe(int sleep_ms)
+{
+	return snor_wait_op_retry_epe(SNOR_OP_NONE, sleep_ms);
+}
+
 static bool snor_wait_error_was_epe(void)
 {
 	return last_wait_error_was_epe;
@@ -139,10 +457,7 @@ static bool snor_wait_error_was_epe(void)
 
 static int snor_read_rg(u8 code, u8 *val) {
     int retval;
-	SPI_CONTROLLER_Chip_Select_Low();
-	SPI_CONTROLLER_Write_One_Byte(code);
-	retval = SPI_CONTROLLER_Read_NByte(val, 1);
-	SPI_CONTROLLER_Chip_Select_High();
+	retval = SPI_CONTROLLER_Transaction(&code, 1, val, 1);
 	if (retval) {
         printf("%s: ret: %x\n", __func__, retval);
         return -1;
@@ -152,10 +467,8 @@ static int snor_read_rg(u8 code, u8 *val) {
 
 static int snor_write_rg(u8 code, u8 *val) {
     int retval;
-	SPI_CONTROLLER_Chip_Select_Low();
-	SPI_CONTROLLER_Write_One_Byte(code);
-	retval = SPI_CONTROLLER_Write_NByte(val, 1);
-	SPI_CONTROLLER_Chip_Select_High();
+	u8 cmd[2] = { code, *val };
+	retval = SPI_CONTROLLER_Transaction(cmd, 2, NULL, 0);
 	if (retval) {
         printf("%s: ret: %x\n", __func__, retval);
         return -1;
@@ -165,31 +478,42 @@ static int snor_write_rg(u8 code, u8 *val) {
 
 static int snor_read_sr2(u8 *val)
 {
-	return snor_read_rg(OPCODE_RDSR2, val);
+	if (!snor_shadow.sr2_valid) {
+		if (snor_read_rg(OPCODE_RDSR2, &snor_shadow.sr2) < 0)
+			return -1;
+		snor_shadow.sr2_valid = true;
+	}
+	*val = snor_shadow.sr2;
+	return 0;
 }
 
 static int snor_read_sr3(u8 *val)
 {
-	return snor_read_rg(OPCODE_RDSR3, val);
+	if (!snor_shadow.sr3_valid) {
+		if (snor_read_rg(OPCODE_RDSR3, &snor_shadow.sr3) < 0)
+			return -1;
+		snor_shadow.sr3_valid = true;
+	}
+	*val = snor_shadow.sr3;
+	return 0;
 }
 
 static int snor_write_sr2(u8 val)
 {
+	snor_shadow_invalidate_sr();
 	return snor_write_rg(OPCODE_WRSR2, &val);
 }
 
 static void snor_volatile_write_enable(void)
 {
-	SPI_CONTROLLER_Chip_Select_Low();
-	SPI_CONTROLLER_Write_One_Byte(OPCODE_WREN_VSR);
-	SPI_CONTROLLER_Chip_Select_High();
+	snor_cmd(OPCODE_WREN_VSR);
 }
 
 /* NOR-MEM helpers: try non-volatile first, then volatile if needed */
 static int snor_write_sr1_nm(u8 sr1_val)
 {
 	snor_write_enable();
-	if (snor_write_sr(&sr1_val) == 0 && snor_wait_ready_retry_epe(1) == 0)
+	if (snor_write_sr(&sr1_val) == 0 && snor_wait_op_retry_epe(SNOR_OP_WRSR, 1) == 0)
 		return 0;
 	/* fallback to volatile write */
 	snor_volatile_write_enable();
@@ -201,7 +525,7 @@ static int snor_write_sr1_nm(u8 sr1_val)
 static int snor_write_sr2_nm(u8 sr2_val)
 {
 	snor_write_enable();
-	if (snor_write_sr2(sr2_val) == 0 && snor_wait_ready_retry_epe(1) == 0)
+	if (snor_write_sr2(sr2_val) == 0 && snor_wait_op_retry_epe(SNOR_OP_WRSR, 1) == 0)
 		return 0;
 	/* fallback to volatile write */
 	snor_volatile_write_enable();
@@ -212,9 +536,44 @@ static int snor_write_sr2_nm(u8 sr2_val)
 
 static int snor_write_sr3(u8 val)
 {
+	snor_shadow_invalidate_sr();
 	return snor_write_rg(OPCODE_WRSR3, &val);
 }
 
+/* Volatile SR1 (and SR2) write: 0x50 instead of WREN takes effect at once,
+ * without a nonvolatile write cycle, and lapses at power-off. Returns 0 once
+ * the bits in mask read back as written; chips without volatile status bits
+ * ignore the write and the caller falls back to WREN. */
+static int snor_write_status_volatile(const u8 *vals, size_t len, u8 mask)
+{
+	u8 sr1;
+
+	SPI_CONTROLLER_Queue_Begin();
+	snor_volatile_write_enable();
+	snor_write_status_block(vals, len);
+	if (SPI_CONTROLLER_Queue_End())
+		return -1;
+	/* Some parts treat 0x50 as a plain enable for a nonvolatile write */
+	if (snor_wait_ready_retry_epe(1) || snor_read_sr(&sr1) < 0)
+		return -1;
+	return ((sr1 ^ vals[0]) & mask) ? -1 : 0;
+}
+
+/* Volatile SR3 write, verified by reading it back */
+static int snor_write_sr3_volatile(u8 val, u8 mask)
+{
+	u8 sr3;
+
+	SPI_CONTROLLER_Queue_Begin();
+	snor_volatile_write_enable();
+	snor_write_sr3(val);
+	if (SPI_CONTROLLER_Queue_End())
+		return -1;
+	if (snor_wait_ready_retry_epe(1) || snor_read_sr3(&sr3) < 0)
+		return -1;
+	return ((sr3 ^ val) & mask) ? -1 : 0;
+}
+
 static void snor_log_status(const char *ctx, u8 sr1)
 {
 	if (!debug_enabled)
@@ -237,17 +596,17 @@ int snor_write_sr(u8 *val) {
 	return snor_write_status_block(val, 1);
 }
 void snor_write_enable(void) {
-    SPI_CONTROLLER_Chip_Select_Low();
-    SPI_CONTROLLER_Write_One_Byte(OPCODE_WREN);
-    SPI_CONTROLLER_Chip_Select_High();
+    snor_cmd(OPCODE_WREN);
+    snor_shadow.wel = true;
 }
 
 static int snor_global_block_unlock(void) {
     printf("[INFO] NOR-MEM: Executing Global Block Unlock\n");
+	SPI_CONTROLLER_Queue_Begin();
 	snor_write_enable();
-    SPI_CONTROLLER_Chip_Select_Low();
-    SPI_CONTROLLER_Write_One_Byte(OPCODE_GBULK);
-    SPI_CONTROLLER_Chip_Select_High();
+    snor_cmd(OPCODE_GBULK);
+	if (SPI_CONTROLLER_Queue_End())
+		return -1;
     return snor_wait_ready_retry_epe(1);
 }
 
@@ -259,15 +618,16 @@ static int snor_block_unlock_all(void)
 	unsigned long sec_sz = spi_chip_info->sector_size;
 	for (unsigned int i = 0; i < n; i++) {
 		unsigned long addr = i * sec_sz;
-		u8 a[3];
-		a[0] = (addr >> 16) & 0xFF;
-		a[1] = (addr >> 8) & 0xFF;
-		a[2] = addr & 0xFF;
+		u8 a[4];
+		a[0] = OPCODE_SBULK;
+		a[1] = (addr >> 16) & 0xFF;
+		a[2] = (addr >> 8) & 0xFF;
+		a[3] = addr & 0xFF;
+		SPI_CONTROLLER_Queue_Begin();
 		snor_write_enable();
-		SPI_CONTROLLER_Chip_Select_Low();
-		SPI_CONTROLLER_Write_One_Byte(OPCODE_SBULK);
-		SPI_CONTROLLER_Write_NByte(a, 3);
-		SPI_CONTROLLER_Chip_Select_High();
+		SPI_CONTROLLER_Transaction(a, 4, NULL, 0);
+		if (SPI_CONTROLLER_Queue_End())
+			return -1;
 		if (snor_wait_ready_retry_epe(1))
 			return -1;
 	}
@@ -276,19 +636,23 @@ static int snor_block_unlock_all(void)
 
 static void snor_reset_chip(void)
 {
-	SPI_CONTROLLER_Chip_Select_Low();
-	SPI_CONTROLLER_Write_One_Byte(OPCODE_RSTEN);
-	SPI_CONTROLLER_Chip_Select_High();
-	SPI_CONTROLLER_Chip_Select_Low();
-	SPI_CONTROLLER_Write_One_Byte(OPCODE_RST);
-	SPI_CONTROLLER_Chip_Select_High();
+	SPI_CONTROLLER_Queue_Begin();
+	snor_cmd(OPCODE_RSTEN);
+	snor_cmd(OPCODE_RST);
+	SPI_CONTROLLER_Queue_End();
 	usleep(1000); /* allow reset to complete */
+	/* Volatile status bits and the addressing mode revert on reset */
+	snor_shadow_invalidate_sr();
+	snor_shadow.addr4b = -1;
+	snor_shadow.wel = false;
 }
 
 void snor_write_disable(void) {
-    SPI_CONTROLLER_Chip_Select_Low();
-    SPI_CONTROLLER_Write_One_Byte(OPCODE_WRDI);
-    SPI_CONTROLLER_Chip_Select_High();
+    /* Every successful wait_ready has already seen WEL clear */
+    if (!snor_shadow.wel)
+        return;
+    snor_cmd(OPCODE_WRDI);
+    snor_shadow.wel = false;
 }
 
 int snor_unprotect(void) {
@@ -302,6 +666,9 @@ int snor_unprotect(void) {
 		/* NOR-MEM chips use 5 bits (BP4-BP0) in SR1 plus CMP bit */
 		bp_mask = SR_BP0 | SR_BP1 | SR_BP2 | SR_BP3 | SR_BP4 | SR_CMP;
 	}
+	/* Nothing we haven't done ourselves can re-protect the chip */
+	if (snor_shadow.unprotected)
+		return 0;
 	if (snor_read_sr(&sr1) < 0) {
 		printf("%s: read_sr fail: %x\n", __func__, sr1);
 		return -1;
@@ -351,20 +718,21 @@ int snor_unprotect(void) {
 	bool clear_sr3_bp = needs_sr3 && (sr3 & SR3_BP3);
 	bool clear_sr3_wps = needs_sr3 && (sr3 & SR3_WPS);
 	bool clear_sr3 = clear_sr3_bp || clear_sr3_wps;
-	if (!clear_sr1 && !clear_sr3 && !clear_sr2_srp)
+	if (!clear_sr1 && !clear_sr3 && !clear_sr2_srp) {
+		snor_shadow.unprotected = true;
 		return 0;
+	}
 
 	if (clear_sr3) {
 		u8 cleared_sr3 = sr3 & ~(SR3_BP3 | SR3_WPS);
-		snor_write_enable();
-		if (snor_write_sr3(cleared_sr3) < 0 || snor_wait_ready_retry_epe(1)) {
-			/* fallback: try volatile write of SR3 */
-			snor_volatile_write_enable();
-			if (snor_write_sr3(cleared_sr3) < 0 || snor_wait_ready_retry_epe(1)) {
+		/* Volatile first: no nonvolatile write cycle on every run */
+		if (snor_write_sr3_volatile(cleared_sr3, SR3_BP3 | SR3_WPS)) {
+			snor_write_enable();
+			if (snor_write_sr3(cleared_sr3) < 0 || snor_wait_op_retry_epe(SNOR_OP_WRSR, 1)) {
 				if (!snor_wait_error_was_epe())
 					return -1;
 				if (debug_enabled)
-					fprintf(stderr, "[DEBUG] snor_unprotect: continuing after SR_EPE while clearing SR3 (volatile)\n");
+					fprintf(stderr, "[DEBUG] snor_unprotect: continuing after SR_EPE while clearing SR3\n");
 			}
 		}
 	}
@@ -391,14 +759,19 @@ int snor_unprotect(void) {
 			buf[len++] = sr1 & ~bp_mask;
 			if (needs_sr2)
 				buf[len++] = sr2;
-			snor_write_enable();
-			if (snor_write_status_block(buf, len) < 0)
-				return -1;
-			if (snor_wait_ready_retry_epe(1)) {
-				if (!snor_wait_error_was_epe())
-					return -1;
+			if (snor_write_status_volatile(buf, len, bp_mask) == 0) {
 				if (debug_enabled)
-					fprintf(stderr, "[DEBUG] snor_unprotect: continuing after SR_EPE while clearing SR1/SR2\n");
+					fprintf(stderr, "[DEBUG] snor_unprotect: cleared SR1 with a volatile write\n");
+			} else {
+				snor_write_enable();
+				if (snor_write_status_block(buf, len) < 0)
+					return -1;
+				if (snor_wait_op_retry_epe(SNOR_OP_WRSR, 1)) {
+					if (!snor_wait_error_was_epe())
+						return -1;
+					if (debug_enabled)
+						fprintf(stderr, "[DEBUG] snor_unprotect: continuing after SR_EPE while clearing SR1/SR2\n");
+				}
 			}
 		}
 	}
@@ -429,11 +802,15 @@ int snor_unprotect(void) {
 		printf("%s: unable to clear write protect selection (SR3=%02x)\n", __func__, sr3);
 		return -1;
 	}
+	snor_shadow.unprotected = true;
 	return 0;
 }
 
 int snor_4byte_mode(int enable) {
     int retval;
+	if (snor_shadow.addr4b == !!enable)
+		return 0;
+	snor_shadow.addr4b = -1;
 	if (snor_wait_ready_retry_epe(1))
         return -1;
     if (spi_chip_info->id == 0x1) { /* Spansion */
@@ -447,9 +824,7 @@ int snor_4byte_mode(int enable) {
         }
     } else {
         u8 code = enable ? 0xb7 : 0xe9;
-        SPI_CONTROLLER_Chip_Select_Low();
-        retval = SPI_CONTROLLER_Write_One_Byte(code);
-        SPI_CONTROLLER_Chip_Select_High();
+        retval = snor_cmd(code);
         if (retval) {
             printf("%s: ret: %x\n", __func__, retval);
             return -1;
@@ -460,39 +835,76 @@ int snor_4byte_mode(int enable) {
             snor_write_rg(0xc5, &code);
         }
     }
+    snor_shadow.addr4b = !!enable;
     return 0;
 }
 
-int snor_erase_sector(unsigned long offset)
+/* Put the chip in its addressing mode for the span of one operation. Calls
+ * nest, so per-sector helpers inside a larger operation switch nothing. */
+static bool snor_needs_addr_mode(void)
+{
+	return spi_chip_info->addr4b && !snor_addr4b_opcodes;
+}
+
+static int snor_addr_mode_begin(void)
 {
+	if (snor_shadow.addr4b_depth++ || !snor_needs_addr_mode())
+		return 0;
+	return snor_4byte_mode(1);
+}
+
+static void snor_addr_mode_end(void)
+{
+	if (!snor_shadow.addr4b_depth || --snor_shadow.addr4b_depth || !snor_needs_addr_mode())
+		return;
+	snor_4byte_mode(0);
+}
+
+/* Timing model slot for an erase type */
+static int snor_erase_op(const struct snor_erase_type *et)
+{
+	int i;
+
+	for (i = 0; i < snor_caps.n_erase; i++)
+		if (snor_caps.erase[i].size == et->size && snor_caps.erase[i].opcode == et->opcode)
+			return SNOR_OP_ERASE + i;
+	return SNOR_OP_SE;
+}
+
+/* Erase one unit of the given type at offset, which it must be aligned to */
+static int snor_erase_unit(unsigned long offset, const struct snor_erase_type *et)
+{
+	u8 cmd[5];
+	unsigned int n;
+
 	snor_set_progress("SE", offset);
 	if (snor_wait_ready_retry_epe(950)) {
 		snor_clear_progress();
 		return -1;
 	}
-	if (spi_chip_info->addr4b)
-		snor_4byte_mode(1);
+	snor_addr_mode_begin();
+	/* WREN and SE share one USB round trip where the programmer supports it */
+	SPI_CONTROLLER_Queue_Begin();
 	snor_write_enable();
-    SPI_CONTROLLER_Chip_Select_Low();
-    SPI_CONTROLLER_Write_One_Byte(OPCODE_SE);
-    if (spi_chip_info->addr4b)
-        SPI_CONTROLLER_Write_One_Byte((offset >> 24) & 0xff);
-    SPI_CONTROLLER_Write_One_Byte((offset >> 16) & 0xff);
-    SPI_CONTROLLER_Write_One_Byte((offset >> 8) & 0xff);
-    SPI_CONTROLLER_Write_One_Byte(offset & 0xff);
-    SPI_CONTROLLER_Chip_Select_High();
-	if (snor_wait_ready(950)) {
-		if (spi_chip_info->addr4b)
-			snor_4byte_mode(0);
+	n = snor_fill_cmd(cmd, et->opcode, offset);
+	SPI_CONTROLLER_Transaction(cmd, n, NULL, 0);
+	if (SPI_CONTROLLER_Queue_End() || snor_wait_op(snor_erase_op(et), 950)) {
+		snor_addr_mode_end();
 		snor_clear_progress();
 		return -1;
 	}
-	if (spi_chip_info->addr4b)
-		snor_4byte_mode(0);
+	snor_addr_mode_end();
 	snor_clear_progress();
 	return 0;
 }
 
+int snor_erase_sector(unsigned long offset)
+{
+	struct snor_erase_type et = snor_sector_erase();
+
+	return snor_erase_unit(offset, &et);
+}
+
 int full_erase_chip(void) {
     timer_start();
 	if (snor_wait_ready_retry_epe(3)) {
@@ -519,10 +931,8 @@ int full_erase_chip(void) {
 		}
 	}
 #endif
-    SPI_CONTROLLER_Chip_Select_Low();
-    SPI_CONTROLLER_Write_One_Byte(OPCODE_BE1);
-    SPI_CONTROLLER_Chip_Select_High();
-    if (snor_wait_ready(950)) {
+    snor_cmd(OPCODE_BE1);
+    if (snor_wait_op(SNOR_OP_BE, 950)) {
 		snor_write_disable();
 		snor_clear_progress();
 		timer_end();
@@ -534,338 +944,15 @@ int full_erase_chip(void) {
     return 0;
 }
 
-static struct chip_info chips_data [] = {
-	/* JEDEC ID format: 0xMMDDVV00 where MM=mfr, DD=device, VV=variant.
-	   Entries with 0x0000 in lower 16 bits use upper-16-bit matching only.
-	   Full IDs will be filled in as datasheets become available. */
-	{ "FL016AIF",		0x01, 0x02140000, 64 * 1024, 32,  0 },
-	{ "S25FL016P",		0x01, 0x02144D00, 64 * 1024, 32,  0 },
-	{ "S25FL032P",		0x01, 0x02154D00, 64 * 1024, 64,  0 },
-	{ "FL064AIF",		0x01, 0x02160000, 64 * 1024, 128, 0 },
-	{ "S25FL064P",		0x01, 0x02164D00, 64 * 1024, 128, 0 },
-	{ "S25FL256S",		0x01, 0x02194D01, 64 * 1024, 512, 1 },
-	{ "S25FL512S",		0x01, 0x02204D00, 256 * 1024, 256, 1 },
-	{ "S25FL128P",		0x01, 0x20180301, 64 * 1024, 256, 0 },
-	{ "S25FL129P",		0x01, 0x20184D01, 64 * 1024, 256, 0 },
-	{ "S25FL116K",		0x01, 0x40150140, 64 * 1024, 32,  0 },
-	{ "S25FL132K",		0x01, 0x40160140, 64 * 1024, 64,  0 },
-	{ "S25FL164K",		0x01, 0x40170140, 64 * 1024, 128, 0 },
-
-	{ "XT25F04D",		0x0b, 0x40130000, 64 * 1024, 8,   0 },
-	{ "XT25F08B",		0x0b, 0x40140000, 64 * 1024, 16,  0 },
-	{ "XT25F16B",		0x0b, 0x40150000, 64 * 1024, 32,  0 },
-	{ "XT25F32B",		0x0b, 0x40160000, 64 * 1024, 64,  0 },
-	{ "XT25F64B",		0x0b, 0x40170000, 64 * 1024, 128, 0 },
-	{ "XT25F128B",		0x0b, 0x40180000, 64 * 1024, 256, 0 },
-	{ "XT25F08D",		0x0b, 0x60140000, 64 * 1024, 16,  0 },
-	{ "XT25Q16D",		0x0b, 0x60150000, 64 * 1024, 32,  0 },
-	{ "XT25Q64D",		0x0b, 0x60170000, 64 * 1024, 128, 0 },
-	{ "XT25F128D",		0x0b, 0x60180000, 64 * 1024, 256, 0 },
-
-	{ "EN25F64",		0x1c, 0x20171c20, 64 * 1024, 128, 0 },
-	{ "EN25Q16",		0x1c, 0x30151c30, 64 * 1024, 32,  0 },
-	{ "EN25Q32B",		0x1c, 0x30161c30, 64 * 1024, 64,  0 },
-	{ "EN25Q64",		0x1c, 0x30171c30, 64 * 1024, 128, 0 },
-	{ "EN25Q128",		0x1c, 0x30181c30, 64 * 1024, 256, 0 },
-	{ "EN25F16",		0x1c, 0x31151c31, 64 * 1024, 32,  0 },
-	{ "EN25F32",		0x1c, 0x31161c31, 64 * 1024, 64,  0 },
-	{ "GM25Q64A",		0x1c, 0x40171c40, 64 * 1024, 128, 0 },
-	{ "GM25Q128A",		0x1c, 0x40181c40, 64 * 1024, 256, 0 },
-	{ "EN25QA64A",		0x1c, 0x60170000, 64 * 1024, 128, 0 },
-	{ "EN25QA128A",		0x1c, 0x60180000, 64 * 1024, 256, 0 },
-	{ "EN25QH16",		0x1c, 0x70151c70, 64 * 1024, 32,  0 },
-	{ "EN25QH64A",		0x1c, 0x70171c70, 64 * 1024, 128, 0 },
-	{ "EN25QH128A",		0x1c, 0x70181c70, 64 * 1024, 256, 0 },
-	{ "EN25Q256",		0x1c, 0x70191c70, 64 * 1024, 512, 1 },
-	{ "EN25XQ128A",		0x1c, 0x71181c71, 64 * 1024, 256, 0 },
-
-	{ "AT26DF161",		0x1f, 0x46000000, 64 * 1024, 32,  0 },
-	{ "AT25DF321",		0x1f, 0x47000000, 64 * 1024, 64,  0 },
-
-	{ "M25P05",		0x20, 0x20100000, 64 * 1024, 1,   0 },
-	{ "M25P10",		0x20, 0x20110000, 64 * 1024, 2,   0 },
-	{ "M25P20",		0x20, 0x20120000, 64 * 1024, 4,   0 },
-	{ "M25P40",		0x20, 0x20130000, 64 * 1024, 8,   0 },
-	{ "M25P80",		0x20, 0x20140000, 64 * 1024, 16,  0 },
-	{ "M25P16",		0x20, 0x20150000, 64 * 1024, 32,  0 },
-	{ "M25P32",		0x20, 0x20160000, 64 * 1024, 64,  0 },
-	{ "M25P64",		0x20, 0x20170000, 64 * 1024, 128, 0 },
-	{ "M25P128",		0x20, 0x20180000, 64 * 1024, 256, 0 },
-	{ "XM25QH10B",		0x20, 0x40110000, 64 * 1024, 2,   0 },
-	{ "XM25QH20B",		0x20, 0x40120000, 64 * 1024, 4,   0 },
-	{ "XM25QH40B",		0x20, 0x40130000, 64 * 1024, 8,   0 },
-	{ "XM25QH80B",		0x20, 0x40140000, 64 * 1024, 16,  0 },
-	{ "XM25QH16C",		0x20, 0x40150000, 64 * 1024, 32,  0 },
-	{ "XM25QH32B",		0x20, 0x40160000, 64 * 1024, 64,  0 },
-	{ "XM25QH64C",		0x20, 0x40170000, 64 * 1024, 128, 0 },
-	{ "XM25QH128C",		0x20, 0x40182070, 64 * 1024, 256, 0 },
-	{ "XM25QH256C",		0x20, 0x40190000, 64 * 1024, 512, 1 },
-	{ "XM25QH512C",		0x20, 0x40200000, 64 * 1024, 1024, 1 },
-	{ "XM25LU64C",		0x20, 0x41170000, 64 * 1024, 128, 0 },
-	{ "XM25LU128C",		0x20, 0x41180000, 64 * 1024, 256, 0 },
-	{ "XM25QU256C",		0x20, 0x41190000, 64 * 1024, 512, 1 },
-	{ "XM25QU512C",		0x20, 0x41200000, 64 * 1024, 1024, 1 },
-	{ "XM25QW16C",		0x20, 0x42150000, 64 * 1024, 32,  0 },
-	{ "XM25QW32C",		0x20, 0x42160000, 64 * 1024, 64,  0 },
-	{ "XM25QW64C",		0x20, 0x42170000, 64 * 1024, 128, 0 },
-	{ "XM25QW128C",		0x20, 0x42180000, 64 * 1024, 256, 0 },
-	{ "XM25QW256C",		0x20, 0x42190000, 64 * 1024, 512, 1 },
-	{ "XM25QW512C",		0x20, 0x42200000, 64 * 1024, 1024, 1 },
-	{ "XM25QU41B",		0x20, 0x50130000, 64 * 1024, 8,   0 },
-	{ "XM25QU80B",		0x20, 0x50140000, 64 * 1024, 16,  0 },
-	{ "XM25QU16B",		0x20, 0x50150000, 64 * 1024, 32,  0 },
-	{ "XM25LU32C",		0x20, 0x50160000, 64 * 1024, 64,  0 },
-	{ "XM25QH32A",		0x20, 0x70160000, 64 * 1024, 64,  0 },
-	{ "XM25QH64A",		0x20, 0x70170000, 64 * 1024, 128, 0 },
-	{ "XM25QH128A",		0x20, 0x70182070, 64 * 1024, 256, 0 },
-	{ "N25Q032A",		0x20, 0xba161000, 64 * 1024, 64,  0 },
-	{ "N25Q064A",		0x20, 0xba171000, 64 * 1024, 128, 0 },
-	{ "MT25QL64AB",		0x20, 0xba171000, 64 * 1024, 128, 0 },
-	{ "N25Q128A",		0x20, 0xba181000, 64 * 1024, 256, 0 },
-	{ "MT25QL128AB",	0x20, 0xba181000, 64 * 1024, 256, 0 },
-	{ "N25Q256A",		0x20, 0xba191000, 64 * 1024, 512, 1 },
-	{ "MT25QL256AB",	0x20, 0xba191000, 64 * 1024, 512, 1 },
-	{ "N25Q512A",		0x20, 0xba201000, 64 * 1024, 1024, 1 },
-	{ "MT25QL512AB",	0x20, 0xba201044, 64 * 1024, 1024, 1 },
-	{ "N25Q016A",		0x20, 0xbb151000, 64 * 1024, 32,  0 },
-	{ "N25Q032A",		0x20, 0xbb161000, 64 * 1024, 64,  0 },
-	{ "N25Q064A",		0x20, 0xbb171000, 64 * 1024, 128, 0 },
-	{ "MT25QU64AB",		0x20, 0xbb171000, 64 * 1024, 128, 0 },
-	{ "N25Q128A",		0x20, 0xbb181000, 64 * 1024, 256, 0 },
-	{ "MT25QU128AB",	0x20, 0xbb181000, 64 * 1024, 256, 0 },
-	{ "MT25QU256AB",	0x20, 0xbb191000, 64 * 1024, 512, 1 },
-	{ "MT25QU512AB",	0x20, 0xbb201044, 64 * 1024, 1024, 1 },
-
-	{ "SK25P32",		0x25, 0x60162560, 64 * 1024, 64,  0 },
-	{ "SK25P64",		0x25, 0x60172560, 64 * 1024, 128, 0 },
-	{ "SK25P128",		0x25, 0x60182560, 64 * 1024, 256, 0 },
-
-	{ "A25L10PU",		0x37, 0x20110000, 64 * 1024, 2,   0 },
-	{ "A25L20PU",		0x37, 0x20120000, 64 * 1024, 4,   0 },
-	{ "A25L040",		0x37, 0x30130000, 64 * 1024, 8,   0 },
-	{ "A25L080",		0x37, 0x30140000, 64 * 1024, 16,  0 },
-	{ "A25L032",		0x37, 0x30160000, 64 * 1024, 64,  0 },
-	{ "A25LQ080",		0x37, 0x40140000, 64 * 1024, 16,  0 },
-	{ "A25LQ16",		0x37, 0x40150000, 64 * 1024, 32,  0 },
-	{ "A25LQ32",		0x37, 0x40160000, 64 * 1024, 64,  0 },
-	{ "A25LQ64",		0x37, 0x40170000, 64 * 1024, 128, 0 },
-
-	{ "ES25P10",		0x4a, 0x20110000, 64 * 1024, 4,   0 },
-	{ "ES25P20",		0x4a, 0x20120000, 64 * 1024, 8,   0 },
-	{ "ES25P40",		0x4a, 0x20130000, 64 * 1024, 16,  0 },
-	{ "ES25P80",		0x4a, 0x20140000, 64 * 1024, 32,  0 },
-	{ "ES25P16",		0x4a, 0x20150000, 64 * 1024, 64,  0 },
-	{ "ES25P32",		0x4a, 0x20160000, 64 * 1024, 128, 0 },
-	{ "ES25M40A",		0x4a, 0x32130000, 64 * 1024, 16,  0 },
-	{ "ES25M80A",		0x4a, 0x32140000, 64 * 1024, 32,  0 },
-	{ "ES25M16A",		0x4a, 0x32150000, 64 * 1024, 64,  0 },
-
-	{ "MD25D20",		0x51, 0x40120000, 64 * 1024, 4,   0 },
-	{ "MD25D40",		0x51, 0x40130000, 64 * 1024, 8,   0 },
-
-	{ "DQ25Q64AS",		0x54, 0x40170000, 64 * 1024, 128, 0 },
-	{ "DQ25Q128AL",		0x54, 0x60180000, 64 * 1024, 256, 0 },
-
-	{ "ZB25VQ16",		0x5e, 0x40150000, 64 * 1024, 32,  0 },
-	{ "ZB25VQ32",		0x5e, 0x40160000, 64 * 1024, 64,  0 },
-	{ "ZB25VQ64",		0x5e, 0x40170000, 64 * 1024, 128, 0 },
-	{ "ZB25VQ128",		0x5e, 0x40180000, 64 * 1024, 256, 0 },
-	{ "ZB25LQ16",		0x5e, 0x50150000, 64 * 1024, 32,  0 },
-	{ "ZB25LQ32",		0x5e, 0x50160000, 64 * 1024, 64,  0 },
-	{ "ZB25LQ64",		0x5e, 0x50170000, 64 * 1024, 128, 0 },
-	{ "ZB25LQ128",		0x5e, 0x50180000, 64 * 1024, 256, 0 },
-
-	{ "LE25U20AMB",		0x62, 0x06120000, 64 * 1024, 4,   0 },
-	{ "LE25U40CMC",		0x62, 0x06130000, 64 * 1024, 8,   0 },
-
-	{ "BY25Q40BL",		0x68, 0x10130000, 64 * 1024, 8,   0 },
-	{ "BY25Q16BL",		0x68, 0x10150000, 64 * 1024, 32,  0 },
-	{ "BY25D05AS",		0x68, 0x40100000, 64 * 1024, 1,   0 },
-	{ "BY25D10AS",		0x68, 0x40110000, 64 * 1024, 2,   0 },
-	{ "BY25D20AS",		0x68, 0x40120000, 64 * 1024, 4,   0 },
-	{ "BY25D40AS",		0x68, 0x40130000, 64 * 1024, 8,   0 },
-	{ "BY25Q80BS",		0x68, 0x40140000, 64 * 1024, 16,  0 },
-	{ "BY25Q16BS",		0x68, 0x40150000, 64 * 1024, 32,  0 },
-	{ "BY25Q32BS",		0x68, 0x40160000, 64 * 1024, 64,  0 },
-	{ "BY25Q64AS",		0x68, 0x40170000, 64 * 1024, 128, 0 },
-	{ "BY25Q128AS",		0x68, 0x40180000, 64 * 1024, 256, 0 },
-	{ "BY25Q256ES",		0x68, 0x40190000, 64 * 1024, 512, 1 },
-	{ "BY25Q40BL",		0x68, 0x60130000, 64 * 1024, 8,   0 },
-	{ "BY25Q32AL",		0x68, 0x60160000, 64 * 1024, 64,  0 },
-	{ "BY25Q64AL",		0x68, 0x60170000, 64 * 1024, 128, 0 },
-	{ "BY25Q128EL",		0x68, 0x60180000, 64 * 1024, 256, 0 },
-
-	{ "PM25LQ016",		0x7f, 0x9d450000, 64 * 1024, 32,  0 },
-	{ "PM25LQ032",		0x7f, 0x9d460000, 64 * 1024, 64,  0 },
-	{ "PM25LQ064",		0x7f, 0x9d470000, 64 * 1024, 128, 0 },
-	{ "PM25LQ128",		0x7f, 0x9d480000, 64 * 1024, 256, 0 },
-
-	{ "PY25Q64HA",		0x85, 0x20170000, 64 * 1024, 128, 0 },
-	{ "PY25Q128HA",		0x85, 0x20180000, 64 * 1024, 256, 0 },
-	{ "P25D05H",		0x85, 0x60100000, 64 * 1024, 1,   0 },
-	{ "P25D10H",		0x85, 0x60110000, 64 * 1024, 2,   0 },
-	{ "P25D20H",		0x85, 0x60120000, 64 * 1024, 4,   0 },
-	{ "P25D40H",		0x85, 0x60130000, 64 * 1024, 8,   0 },
-	{ "P25D80H",		0x85, 0x60140000, 64 * 1024, 16,  0 },
-	{ "P25Q16H",		0x85, 0x60150000, 64 * 1024, 32,  0 },
-	{ "P25Q32H",		0x85, 0x60160000, 64 * 1024, 64,  0 },
-	{ "P25Q64H",		0x85, 0x60170000, 64 * 1024, 128, 0 },
-	{ "P25Q128H",		0x85, 0x60180000, 64 * 1024, 256, 0 },
-
-	{ "F25L016",		0x8c, 0x21150000, 64 * 1024, 32,  0 },
-	{ "F25L032",		0x8c, 0x21160000, 64 * 1024, 64,  0 },
-	{ "F25L064",		0x8c, 0x21170000, 64 * 1024, 128, 0 },
-	{ "F25L16QA",		0x8c, 0x41158c41, 64 * 1024, 32,  0 },
-	{ "F25L32QA",		0x8c, 0x41168c41, 64 * 1024, 64,  0 },
-	{ "F25L64QA",		0x8c, 0x41170000, 64 * 1024, 128, 0 },
-
-	{ "IS25LQ010", 		0x9d, 0x40110000, 64 * 1024, 2,   0 },
-	{ "IS25LQ020", 		0x9d, 0x40120000, 64 * 1024, 4,   0 },
-	{ "IS25LP080D",		0x9d, 0x60140000, 64 * 1024, 16,  0 },
-	{ "IS25LP016D",		0x9d, 0x60150000, 64 * 1024, 32,  0 },
-	{ "IS25LP032D",		0x9d, 0x60160000, 64 * 1024, 64,  0 },
-	{ "IS25LP064D",		0x9d, 0x60170000, 64 * 1024, 128, 0 },
-	{ "IS25LP128F",		0x9d, 0x60180000, 64 * 1024, 256, 0 },
-	{ "IS25LP256D",		0x9d, 0x60190000, 64 * 1024, 512, 1 },  /* 256 Mb density */
-	{ "IS25LP256D",		0x9d, 0x601A0000, 64 * 1024, 1024, 1 }, /* 512 Mb density */
-	{ "IS25WP040D",		0x9d, 0x70130000, 64 * 1024, 8,   0 },
-	{ "IS25WP080D",		0x9d, 0x70140000, 64 * 1024, 16,  0 },
-	{ "IS25WP016D",		0x9d, 0x70150000, 64 * 1024, 32,  0 },
-	{ "IS25WP032D",		0x9d, 0x70160000, 64 * 1024, 64,  0 },
-	{ "IS25WP064D",		0x9d, 0x70170000, 64 * 1024, 128, 0 },
-	{ "IS25WP128F",		0x9d, 0x70180000, 64 * 1024, 256, 0 },
-	{ "IS25WP256D",		0x9d, 0x70190000, 64 * 1024, 512, 1 },
-	{ "IS25WP256D",		0x9d, 0x701A0000, 64 * 1024, 1024, 1 },
-
-	{ "FM25W04",		0xa1, 0x28130000, 64 * 1024, 8,   0 },
-	{ "FM25W16",		0xa1, 0x28150000, 64 * 1024, 32,  0 },
-	{ "FM25W32",		0xa1, 0x28160000, 64 * 1024, 64,  0 },
-	{ "FM25W64",		0xa1, 0x28170000, 64 * 1024, 128, 0 },
-	{ "FM25W128",		0xa1, 0x28180000, 64 * 1024, 256, 0 },
-	{ "FM25Q04",		0xa1, 0x40130000, 64 * 1024, 8,   0 },
-	{ "FM25Q08",		0xa1, 0x40140000, 64 * 1024, 16,  0 },
-	{ "FM25Q16",		0xa1, 0x40150000, 64 * 1024, 32,  0 },
-	{ "FS25Q32",		0xa1, 0x40160000, 64 * 1024, 64,  0 },
-	{ "FS25Q64",		0xa1, 0x40170000, 64 * 1024, 128, 0 },
-	{ "FS25Q128",		0xa1, 0x40180000, 64 * 1024, 256, 0 },
-
-	{ "ZD25Q16B",		0xba, 0x32150000, 64 * 1024, 32,  0 },
-	{ "ZD25Q32B",		0xba, 0x32160000, 64 * 1024, 64,  0 },
-	{ "ZD25Q64B",		0xba, 0x32170000, 64 * 1024, 128, 0 },
-	{ "ZD25Q128B",		0xba, 0x32180000, 64 * 1024, 256, 0 },
-	{ "ZD25Q16A",		0xba, 0x40150000, 64 * 1024, 32,  0 },
-	{ "ZD25Q32A",		0xba, 0x40160000, 64 * 1024, 64,  0 },
-	{ "ZD25Q64A",		0xba, 0x40170000, 64 * 1024, 128, 0 },
-	{ "ZD25Q128A",		0xba, 0x40180000, 64 * 1024, 256, 0 },
-
-	{ "PCT25VF016B",	0xbf, 0x25410000, 64 * 1024, 32,  0 },
-	{ "PCT25VF032B",	0xbf, 0x254a0000, 64 * 1024, 64,  0 },
-	{ "PCT25VF064C",	0xbf, 0x254b0000, 64 * 1024, 128, 0 },
-	{ "PCT25VF020B",	0xbf, 0x258c0000, 64 * 1024, 4,   0 },
-	{ "PCT25VF040B",	0xbf, 0x258d0000, 64 * 1024, 8,   0 },
-	{ "PCT25VF080B",	0xbf, 0x258e0000, 64 * 1024, 16,  0 },
-	{ "PCT26VF016",		0xbf, 0x26010000, 64 * 1024, 32,  0 },
-	{ "PCT26VF032",		0xbf, 0x26020000, 64 * 1024, 64,  0 },
-	{ "PCT25VF010A",	0xbf, 0x49000000, 64 * 1024, 2,   0 },
-
-	{ "MX25L4005A",		0xc2, 0x2013c220, 64 * 1024, 8,   0 },
-	{ "MX25L8005M",		0xc2, 0x2014c220, 64 * 1024, 16,  0 },
-	{ "MX25L1605D",		0xc2, 0x2015c220, 64 * 1024, 32,  0 },
-	{ "MX25L3205D",		0xc2, 0x2016c220, 64 * 1024, 64,  0 },
-	{ "MX25L6405D",		0xc2, 0x2017c220, 64 * 1024, 128, 0 },
-	{ "MX25L12805D",	0xc2, 0x2018c220, 64 * 1024, 256, 0 },
-	{ "MX25L25635E",	0xc2, 0x2019c220, 64 * 1024, 512, 1 },
-	{ "MX25L51245G",	0xc2, 0x201ac220, 64 * 1024, 1024, 1 },
-	{ "MX25U1635F",		0xc2, 0x2535c220, 64 * 1024, 32,  0 },
-	{ "MX25U3235F",		0xc2, 0x2536c220, 64 * 1024, 64,  0 },
-	{ "MX25U6435F",		0xc2, 0x2537c220, 64 * 1024, 128, 0 },
-	{ "MX25U12835F",	0xc2, 0x2538c220, 64 * 1024, 256, 0 },
-	{ "MX25U25643G",	0xc2, 0x2539c220, 64 * 1024, 512, 1 },
-	{ "MX25U51245G",	0xc2, 0x253ac220, 64 * 1024, 1024, 1 },
-
-	{ "GD25Q20C",		0xc8, 0x40120000, 64 * 1024, 4,   0 },
-	{ "GD25Q40C",		0xc8, 0x40130000, 64 * 1024, 8,   0 },
-	{ "GD25Q80C",		0xc8, 0x40140000, 64 * 1024, 16,  0 },
-	{ "GD25Q16",		0xc8, 0x40150000, 64 * 1024, 32,  0 },
-	{ "GD25Q32",		0xc8, 0x40160000, 64 * 1024, 64,  0 },
-	{ "GD25Q64CSIG",	0xc8, 0x4017c840, 64 * 1024, 128, 0 },
-	{ "GD25Q128CSIG",	0xc8, 0x4018c840, 64 * 1024, 256, 0 },
-	{ "GD25Q256CSIG",	0xc8, 0x4019c840, 64 * 1024, 512, 1 },
-	{ "GD25F256F",		0xc8, 0x43190000, 64 * 1024, 512, 1 },
-	{ "GD25LQ80C",		0xc8, 0x60140000, 64 * 1024, 16,  0 },
-	{ "GD25LQ16C",		0xc8, 0x60150000, 64 * 1024, 32,  0 },
-	{ "GD25LQ32E",		0xc8, 0x60160000, 64 * 1024, 64,  0 },
-	{ "GD25LQ64E",		0xc8, 0x60170000, 64 * 1024, 128, 0 },
-	{ "GD25LQ128D",		0xc8, 0x60180000, 64 * 1024, 256, 0 },
-	{ "GD25WD80C",		0xc8, 0x64140000, 64 * 1024, 16,  0 },
-	{ "GD25WQ80E",		0xc8, 0x65140000, 64 * 1024, 16,  0 },
-	{ "GD25WQ16E",		0xc8, 0x65150000, 64 * 1024, 32,  0 },
-	{ "GD25WQ32E",		0xc8, 0x65160000, 64 * 1024, 64,  0 },
-
-	{ "YC25Q128",		0xd8, 0x4018d840, 64 * 1024, 256, 0 },
-
-	{ "PN25F16",		0xe0, 0x40150000, 64 * 1024, 32,  0 },
-	{ "PN25F32",		0xe0, 0x40160000, 64 * 1024, 64,  0 },
-	{ "PN25F64",		0xe0, 0x40170000, 64 * 1024, 128, 0 },
-	{ "PN25F128",		0xe0, 0x40180000, 64 * 1024, 256, 0 },
-
-	{ "W25X05",		0xef, 0x30100000, 64 * 1024, 1,   0 },
-	{ "W25X10",		0xef, 0x30110000, 64 * 1024, 2,   0 },
-	{ "W25X20",		0xef, 0x30120000, 64 * 1024, 4,   0 },
-	{ "W25X40",		0xef, 0x30130000, 64 * 1024, 8,   0 },
-	{ "W25X80",		0xef, 0x30140000, 64 * 1024, 16,  0 },
-	{ "W25X16",		0xef, 0x30150000, 64 * 1024, 32,  0 },
-	{ "W25X32VS",		0xef, 0x30160000, 64 * 1024, 64,  0 },
-	{ "W25X64",		0xef, 0x30170000, 64 * 1024, 128, 0 },
-	{ "W25Q20CL",		0xef, 0x40120000, 64 * 1024, 4,   0 },
-	{ "W25Q80BL",		0xef, 0x40140000, 64 * 1024, 16,  0 },
-	{ "W25Q16JQ",		0xef, 0x40150000, 64 * 1024, 32,  0 },
-	{ "W25Q32BV",		0xef, 0x40160000, 64 * 1024, 64,  0 },
-	{ "W25Q64BV",		0xef, 0x40170000, 64 * 1024, 128, 0 },
-	{ "W25Q128BV",		0xef, 0x40180000, 64 * 1024, 256, 0 },
-	{ "W25Q256FV",		0xef, 0x40190000, 64 * 1024, 512, 1 },
-	{ "W25Q512JV",		0xef, 0x40200000, 64 * 1024, 1024, 1 },
-	{ "W25Q20BW",		0xef, 0x50120000, 64 * 1024, 4,   0 },
-	{ "W25Q80",		0xef, 0x50140000, 64 * 1024, 16,  0 },
-	{ "W25Q20EW",		0xef, 0x60120000, 64 * 1024, 4,   0 },
-	{ "W25Q32DW",		0xef, 0x60160000, 64 * 1024, 64,  0 },
-	{ "W25Q64DW",		0xef, 0x60170000, 64 * 1024, 128, 0 },
-	{ "W25Q128FW",		0xef, 0x60180000, 64 * 1024, 256, 0 },
-	{ "W25Q256JW",		0xef, 0x60190000, 64 * 1024, 512, 1 },
-	{ "W25Q512NW",		0xef, 0x60200000, 64 * 1024, 1024, 1 },
-	{ "W25Q16JM",		0xef, 0x70150000, 64 * 1024, 32,  0 },
-	{ "W25Q64JVIM",		0xef, 0x70170000, 64 * 1024, 128, 0 },
-	{ "W25Q512JVIM",	0xef, 0x70200000, 64 * 1024, 1024, 1 },
-	{ "W25Q32JWIM",		0xef, 0x80160000, 64 * 1024, 64,  0 },
-	{ "W25Q64JWIM",		0xef, 0x80170000, 64 * 1024, 128, 0 },
-	{ "W25Q256JWIM",	0xef, 0x80190000, 64 * 1024, 512, 1 },
-	{ "W25Q512NWIM",	0xef, 0x80200000, 64 * 1024, 1024, 1 },
-
-
-	{ "FM25Q04A",		0xf8, 0x32130000, 64 * 1024, 8,	  0 },
-	{ "FM25Q08A",		0xf8, 0x32140000, 64 * 1024, 16,  0 },
-	{ "FM25Q16A",		0xf8, 0x32150000, 64 * 1024, 32,  0 },
-	{ "FM25Q32A",		0xf8, 0x32160000, 64 * 1024, 64,  0 },
-	{ "FM25Q64A",		0xf8, 0x32170000, 64 * 1024, 128, 0 },
-	{ "FM25Q128A",		0xf8, 0x32180000, 64 * 1024, 256, 0 },
-	{ "FM25M04A",		0xf8, 0x42130000, 64 * 1024, 8,   0 },
-	{ "FM25M08A",		0xf8, 0x42140000, 64 * 1024, 16,  0 },
-	{ "FM25M16A",		0xf8, 0x42150000, 64 * 1024, 32,  0 },
-	{ "FM25M32B",		0xf8, 0x42160000, 64 * 1024, 64,  0 },
-	{ "FM25M64A",		0xf8, 0x42170000, 64 * 1024, 128, 0 },
-};
-
 /*
  * read SPI flash device ID
  */
 static int snor_read_devid(u8 *rxbuf, int n_rx)
 {
 	int retval = 0;
+	u8 code = OPCODE_RDID;
 
-	SPI_CONTROLLER_Chip_Select_Low();
-	SPI_CONTROLLER_Write_One_Byte(OPCODE_RDID);
-	retval = SPI_CONTROLLER_Read_NByte(rxbuf, n_rx);
-	SPI_CONTROLLER_Chip_Select_High();
+	retval = SPI_CONTROLLER_Transaction(&code, 1, rxbuf, n_rx);
 	if (retval) {
 		printf("%s: ret: %x\n", __func__, retval);
 		return retval;
@@ -875,58 +962,305 @@ static int snor_read_devid(u8 *rxbuf, int n_rx)
 }
 
 /*
- * Verify chips_data is sorted by (id, jedec_id) at startup
+ * SFDP (JESD216) discovery: geometry, timings and command set straight from
+ * the chip, for parts the table lacks or describes only coarsely
  */
-static void verify_chips_sorted(void)
+#define SFDP_SIGNATURE 0x50444653 /* "SFDP" */
+#define SFDP_MAX_HEADERS 8
+#define SFDP_MAX_DWORDS 24
+#define SFDP_BFPT_ID 0xff00      /* basic flash parameter table */
+#define SFDP_4BAIT_ID 0xff84     /* 4-byte address instruction table */
+
+static struct snor_caps snor_sfdp;      /* last successful parse */
+static bool snor_sfdp_valid = false;
+static bool snor_sfdp_addr4b = false;   /* 4BAIT covers every opcode we use */
+
+static int snor_read_sfdp(u32 addr, u8 *buf, u32 len)
 {
-	static int verified = 0;
-	if (verified) return;
+	u8 cmd[5];
+
+	cmd[0] = OPCODE_SFDP;
+	cmd[1] = (addr >> 16) & 0xff;
+	cmd[2] = (addr >> 8) & 0xff;
+	cmd[3] = addr & 0xff;
+	cmd[4] = 0xff; /* 8 dummy clocks */
+	return SPI_CONTROLLER_Transaction(cmd, 5, buf, len);
+}
+
+static u32 sfdp_dword(const u8 *p)
+{
+	return (u32)p[0] | ((u32)p[1] << 8) | ((u32)p[2] << 16) | ((u32)p[3] << 24);
+}
 
-	int n = sizeof(chips_data) / sizeof(chips_data[0]);
-	for (int i = 1; i < n; i++) {
-		if (chips_data[i].id < chips_data[i-1].id) {
-			fprintf(stderr, "FATAL: chips_data not sorted by id at index %d\n", i);
-			exit(1);
+/* Read a parameter table as DWORDs, at most SFDP_MAX_DWORDS of them */
+static int snor_sfdp_table(const u8 *hdr, u32 *dw, int *n_dw)
+{
+	u8 buf[SFDP_MAX_DWORDS * 4];
+	u32 ptp = (u32)hdr[4] | ((u32)hdr[5] << 8) | ((u32)hdr[6] << 16);
+	int i, n = min(hdr[3], SFDP_MAX_DWORDS);
+
+	if (!n || snor_read_sfdp(ptp, buf, n * 4))
+		return -1;
+	for (i = 0; i < n; i++)
+		dw[i] = sfdp_dword(&buf[i * 4]);
+	*n_dw = n;
+	return 0;
+}
+
+/* Typical times: a 5-bit count with a 2-bit unit selector */
+static u32 sfdp_time(u32 field, const u32 *unit)
+{
+	return ((field & 0x1f) + 1) * unit[(field >> 5) & 3];
+}
+
+static int snor_sfdp_parse_bfpt(const u32 *dw, int n, struct snor_caps *caps)
+{
+	static const u32 erase_unit_ms[] = { 1, 16, 128, 1000 };
+	static const u32 chip_unit_ms[] = { 16, 256, 4000, 64000 };
+	u32 mult, typ;
+	int i, j;
+
+	if (n < 9)
+		return -1;
+	memset(caps, 0, sizeof(*caps));
+	caps->sfdp = true;
+
+	/* DWORD 2: density in bits */
+	if (dw[1] & 0x80000000) {
+		if ((dw[1] & 0x7fffffff) < 3 || (dw[1] & 0x7fffffff) > 34)
+			return -1;
+		caps->size = 1UL << ((dw[1] & 0x7fffffff) - 3);
+	} else {
+		caps->size = ((unsigned long)dw[1] + 1) >> 3;
+	}
+	if (!caps->size)
+		return -1;
+
+	/* DWORDs 8-9: erase types; DWORD 10: their typical times */
+	mult = n >= 10 ? (dw[9] & 0xf) : 0;
+	for (i = 0; i < SNOR_ERASE_TYPES; i++) {
+		u32 field = (dw[7 + i / 2] >> (16 * (i % 2))) & 0xffff;
+		struct snor_erase_type et = { 0, field >> 8, 0, 0 };
+
+		if (!(field & 0xff) || (field & 0xff) > 31)
+			continue;
+		et.size = 1U << (field & 0xff);
+		if (n >= 10) {
+			et.typ_ms = sfdp_time(dw[9] >> (4 + 7 * i), erase_unit_ms);
+			et.max_ms = 2 * (mult + 1) * et.typ_ms;
 		}
-		if (chips_data[i].id == chips_data[i-1].id &&
-		    chips_data[i].jedec_id < chips_data[i-1].jedec_id) {
-			fprintf(stderr, "FATAL: chips_data not sorted by jedec at index %d\n", i);
-			exit(1);
+		/* keep the list ascending by size */
+		for (j = caps->n_erase; j > 0 && caps->erase[j - 1].size > et.size; j--)
+			caps->erase[j] = caps->erase[j - 1];
+		caps->erase[j] = et;
+		caps->n_erase++;
+	}
+	/* JESD216 without erase types still states uniform 4K erase in DWORD 1 */
+	if (!caps->n_erase && (dw[0] & 3) == 1) {
+		caps->erase[0].size = 0x1000;
+		caps->erase[0].opcode = (dw[0] >> 8) & 0xff;
+		caps->n_erase = 1;
+	}
+
+	/* DWORD 11: page size, program and chip erase times */
+	caps->page_size = FLASH_PAGESIZE;
+	if (n >= 11) {
+		mult = dw[10] & 0xf;
+		caps->page_size = 1U << ((dw[10] >> 4) & 0xf);
+		typ = (((dw[10] >> 8) & 0x1f) + 1) * ((dw[10] & (1 << 13)) ? 64 : 8);
+		caps->page_typ_us = typ;
+		caps->page_max_us = 2 * (mult + 1) * typ;
+		caps->chip_typ_ms = sfdp_time(dw[10] >> 24, chip_unit_ms);
+		caps->chip_max_ms = 2 * (mult + 1) * caps->chip_typ_ms;
+	}
+
+	/* DWORDs 1 and 4: 1-1-2 fast read, usable when its dummy and mode
+	 * clocks come to whole bytes */
+	if (dw[0] & (1 << 16)) {
+		u8 wait = (dw[3] & 0x1f) + ((dw[3] >> 5) & 7);
+		if (((dw[3] >> 8) & 0xff) && !(wait % 8) && wait <= 16) {
+			caps->dual_opcode = (dw[3] >> 8) & 0xff;
+			caps->dual_wait = wait;
 		}
 	}
-	verified = 1;
+	return 0;
 }
 
-/*
- * Binary search to find chip in sorted table (O(log n) vs O(n))
- */
-static struct chip_info *chip_prob_binary_search(u8 mfr_id, u32 jedec, u32 jedec_strip)
+/* The 4-byte opcodes must cover reads, page program and every erase type
+ * with exactly the forms snor_opcode4b() sends */
+static bool snor_sfdp_parse_4bait(const u32 *dw, int n, struct snor_caps *caps)
+{
+	int i;
+
+	if (n < 2 || (dw[0] & 0x43) != 0x43)
+		return false;
+	for (i = 0; i < caps->n_erase; i++) {
+		u8 code4b = snor_opcode4b(caps->erase[i].opcode);
+		bool found = false;
+		int t;
+
+		for (t = 0; t < SNOR_ERASE_TYPES && code4b; t++)
+			if ((dw[0] & (1 << (9 + t))) && ((dw[1] >> (8 * t)) & 0xff) == code4b)
+				found = true;
+		if (!found)
+			return false;
+	}
+	if (caps->dual_opcode && (caps->dual_opcode != OPCODE_DOR || !(dw[0] & (1 << 2))))
+		caps->dual_opcode = 0;
+	return true;
+}
+
+static int snor_sfdp_probe(void)
 {
-	int left, right, mid;
+	u8 hdr[8], phdr[SFDP_MAX_HEADERS * 8];
+	u32 dw[SFDP_MAX_DWORDS];
+	const u8 *bfpt = NULL, *bait = NULL;
+	int i, n, nph;
+
+	snor_sfdp_valid = false;
+	snor_sfdp_addr4b = false;
+	if (snor_read_sfdp(0, hdr, sizeof(hdr)) || sfdp_dword(hdr) != SFDP_SIGNATURE)
+		return -1;
+	nph = min(hdr[6] + 1, SFDP_MAX_HEADERS);
+	if (snor_read_sfdp(8, phdr, nph * 8))
+		return -1;
+	for (i = 0; i < nph; i++) {
+		u16 id = ((u16)phdr[i * 8 + 7] << 8) | phdr[i * 8];
+		if (id == SFDP_BFPT_ID && !bfpt)
+			bfpt = &phdr[i * 8];
+		else if (id == SFDP_4BAIT_ID && !bait)
+			bait = &phdr[i * 8];
+	}
+	if (!bfpt || snor_sfdp_table(bfpt, dw, &n) || snor_sfdp_parse_bfpt(dw, n, &snor_sfdp))
+		return -1;
+	if (bait && !snor_sfdp_table(bait, dw, &n))
+		snor_sfdp_addr4b = snor_sfdp_parse_4bait(dw, n, &snor_sfdp);
+	snor_sfdp_valid = true;
 
-	left = 0;
-	right = sizeof(chips_data)/sizeof(chips_data[0]) - 1;
+	if (debug_enabled) {
+		fprintf(stderr, "[DEBUG] SFDP: rev %u.%u, %lu bytes, page %u, 4-byte opcodes %s\n",
+			hdr[5], hdr[4], snor_sfdp.size, snor_sfdp.page_size, snor_sfdp_addr4b ? "yes" : "no");
+		for (i = 0; i < snor_sfdp.n_erase; i++)
+			fprintf(stderr, "[DEBUG] SFDP: erase %5u bytes with 0x%02x, typ %u ms, max %u ms\n",
+				snor_sfdp.erase[i].size, snor_sfdp.erase[i].opcode,
+				snor_sfdp.erase[i].typ_ms, snor_sfdp.erase[i].max_ms);
+		fprintf(stderr, "[DEBUG] SFDP: dual read 0x%02x wait %u, page program typ %u us max %u us, chip erase max %u ms\n",
+			snor_sfdp.dual_opcode, snor_sfdp.dual_wait, snor_sfdp.page_typ_us,
+			snor_sfdp.page_max_us, snor_sfdp.chip_max_ms);
+	}
+	return 0;
+}
 
-	while (left <= right) {
-		mid = (left + right) / 2;
-		struct chip_info *info = &chips_data[mid];
+/* Describe a chip the table lacks by its SFDP geometry, erased in units of
+ * its largest erase type */
+static struct chip_info *snor_sfdp_chip(u8 mfr_id, u32 jedec)
+{
+	static struct chip_info info;
+	static char name[24];
+	const struct snor_erase_type *et;
+
+	if (!snor_sfdp_valid || !snor_sfdp.n_erase)
+		return NULL;
+	et = &snor_sfdp.erase[snor_sfdp.n_erase - 1];
+	if (snor_sfdp.size % et->size)
+		return NULL;
+	snprintf(name, sizeof(name), "SFDP-%02X%04X", mfr_id, jedec >> 16);
+	info.name = name;
+	info.id = mfr_id;
+	info.jedec_id = jedec;
+	info.sector_size = et->size;
+	info.n_sectors = snor_sfdp.size / et->size;
+	if (snor_sfdp.size <= 0x1000000)
+		info.addr4b = SNOR_ADDR3B;
+	else
+		info.addr4b = snor_sfdp_addr4b ? SNOR_ADDR4B_OPCODES : SNOR_ADDR4B_MODE;
+	return &info;
+}
 
-		if (info->id == mfr_id) {
-			if ((info->jedec_id == jedec) || ((info->jedec_id & 0xffff0000) == jedec_strip))
-				return info;
+/* The table entry's sector erase as the only erase type */
+static void snor_caps_table_erase(void)
+{
+	snor_caps.n_erase = 1;
+	memset(&snor_caps.erase[0], 0, sizeof(snor_caps.erase[0]));
+	snor_caps.erase[0].size = spi_chip_info->sector_size;
+	snor_caps.erase[0].opcode = OPCODE_SE;
+	snor_caps.erase[0].max_ms = spi_chip_info->erase_max_ms;
+}
 
-			if (jedec_strip > (info->jedec_id & 0xffff0000))
-				left = mid + 1;
-			else
-				right = mid - 1;
-		} else if (info->id > mfr_id) {
-			right = mid - 1;
-		} else {
-			left = mid + 1;
+/* Settle snor_caps for the detected chip: SFDP when it agrees with the table
+ * entry on size, the table entry alone otherwise */
+static void snor_caps_init(void)
+{
+	unsigned long size = spi_chip_info->sector_size * spi_chip_info->n_sectors;
+
+	if (snor_sfdp_valid && snor_sfdp.size == size) {
+		snor_caps = snor_sfdp;
+		/* SFDP without a usable erase type still gives the rest */
+		if (!snor_caps.n_erase)
+			snor_caps_table_erase();
+		return;
+	}
+	if (snor_sfdp_valid && debug_enabled)
+		fprintf(stderr, "[DEBUG] snor_init: SFDP size %lu disagrees with table size %lu, SFDP ignored\n",
+			snor_sfdp.size, size);
+	snor_sfdp_addr4b = false;
+	memset(&snor_caps, 0, sizeof(snor_caps));
+	snor_caps.size = size;
+	snor_caps.page_size = FLASH_PAGESIZE;
+	snor_caps_table_erase();
+	snor_caps.page_max_us = spi_chip_info->page_max_us;
+	snor_caps.dual_opcode = OPCODE_DOR;
+	snor_caps.dual_wait = 8;
+}
+
+/*
+ * 4-byte opcodes taken from the table entry rather than a 4BAIT: only 0x21
+ * and 0xDC are known to exist on such chips, so drop the erase types whose
+ * 4-byte form is a guess (0x5C for 0x52, vendor opcodes) instead of sending
+ * an opcode the chip may not have
+ */
+static void snor_caps_addr4b_erase(void)
+{
+	int i, n = 0;
+
+	for (i = 0; i < snor_caps.n_erase; i++) {
+		if (snor_caps.erase[i].opcode != OPCODE_P4E &&
+		    snor_caps.erase[i].opcode != OPCODE_SE) {
+			if (debug_enabled)
+				fprintf(stderr, "[DEBUG] snor_init: dropping %uK erase 0x%02x, no verified 4-byte form\n",
+					snor_caps.erase[i].size >> 10, snor_caps.erase[i].opcode);
+			continue;
 		}
+		snor_caps.erase[n++] = snor_caps.erase[i];
 	}
+	snor_caps.n_erase = n;
+	if (!snor_caps.n_erase)
+		snor_caps_table_erase();
+}
 
-	return NULL;
+/*
+ * Look the ID up in the index chipdb_gen built over chips_data: of the
+ * entries sharing its upper 16 bits, prefer the exact ID, then an entry that
+ * only gives those bits, then the first
+ */
+static struct chip_info *chip_prob_lookup(u8 mfr_id, u32 jedec)
+{
+	const struct chipdb_slot *slot;
+	struct chip_info *info, *match = NULL;
+	int i;
+
+	slot = chipdb_find(snor_index_slots, SNOR_INDEX_MULT, SNOR_INDEX_BITS,
+			   CHIPDB_NOR_KEY(mfr_id, jedec));
+	if (!slot)
+		return NULL;
+	for (i = slot->first; i < slot->first + slot->count; i++) {
+		info = &chips_data[i];
+		if (info->jedec_id == jedec)
+			return info;
+		if (!match && !(info->jedec_id & 0xffff))
+			match = info;
+	}
+	return match ? match : &chips_data[slot->first];
 }
 
 /*
@@ -935,11 +1269,11 @@ static struct chip_info *chip_prob_binary_search(u8 mfr_id, u32 jedec, u32 jedec
 int snor_read_sr(u8 *val)
 {
 	int retval = 0;
+	u8 code = OPCODE_RDSR;
 
-	SPI_CONTROLLER_Chip_Select_Low();
-	SPI_CONTROLLER_Write_One_Byte(OPCODE_RDSR);
-	retval = SPI_CONTROLLER_Read_NByte(val, 1);
-	SPI_CONTROLLER_Chip_Select_High();
+	retval = SPI_CONTROLLER_Read_Status(val);
+	if (retval == SPI_CONTROLLER_RTN_NOT_SUPPORTED)
+		retval = SPI_CONTROLLER_Transaction(&code, 1, val, 1);
 	if (retval) {
 		printf("%s: ret: %x\n", __func__, retval);
 		return retval;
@@ -952,23 +1286,24 @@ struct chip_info *chip_prob(void)
 {
 	struct chip_info *info = NULL, *match = NULL;
 	u8 buf[5];
-	u32 jedec, jedec_strip, weight;
+	u32 jedec, weight;
 	int i;
 
-	verify_chips_sorted();
-
 	snor_read_devid(buf, 5);
 	jedec = (u32)((u32)(buf[1] << 24) | ((u32)buf[2] << 16) | ((u32)buf[3] <<8) | (u32)buf[4]);
-	jedec_strip = jedec & 0xffff0000;
 
-	/* Primary lookup: binary search in sorted table (O(log n)) */
-	info = chip_prob_binary_search(buf[0], jedec, jedec_strip);
+	/* Primary lookup: perfect hash built with the table (O(1)) */
+	info = chip_prob_lookup(buf[0], jedec);
+
+	/* Unknown part: its own SFDP tables give exact geometry */
+	if (!info)
+		info = snor_sfdp_chip(buf[0], jedec);
 
 	/* Fallback: linear search for closest weight match */
 	if (!info) {
 		weight = 0xffffffff;
 		match = &chips_data[0];
-		for (i = 0; (unsigned long)i < sizeof(chips_data)/sizeof(chips_data[0]); i++) {
+		for (i = 0; (size_t)i < get_spi_nor_flash_table_size(); i++) {
 			info = &chips_data[i];
 			if (info->id == buf[0]) {
 				if (weight > (info->jedec_id ^ jedec)) {
@@ -995,30 +1330,208 @@ struct chip_info *chip_prob(void)
 
 long snor_init(void)
 {
+	snor_shadow_reset();
+	snor_sfdp_probe();
 	spi_chip_info = chip_prob();
 
 	if(spi_chip_info == NULL)
 		return -1;
 
-	bsize = spi_chip_info->sector_size;
+	snor_caps_init();
+	snor_addr4b_opcodes = spi_chip_info->addr4b == SNOR_ADDR4B_OPCODES ||
+		(spi_chip_info->addr4b && snor_sfdp_addr4b);
+	if (snor_addr4b_opcodes && !snor_sfdp_addr4b)
+		snor_caps_addr4b_erase();
+	snor_timing_init();
+	/* Erases go down to the smallest erase type, see snor_erase() */
+	bsize = snor_caps.n_erase ? snor_caps.erase[0].size : spi_chip_info->sector_size;
+	if (debug_enabled && spi_chip_info->addr4b)
+		fprintf(stderr, "[DEBUG] snor_init: 4-byte addressing via %s\n",
+			snor_addr4b_opcodes ? "dedicated opcodes" : "EN4B/EX4B mode switch");
 
 	return spi_chip_info->sector_size * spi_chip_info->n_sectors;
 }
 
+/*
+ * Erase planner: covers a range with the cheapest mix of the chip's erase
+ * types, or a chip erase when the range is the whole chip and that is
+ * cheaper. Costs are SFDP typical times where known, datasheet-typical
+ * figures otherwise, plus a fixed per-command overhead.
+ */
+#define SNOR_ERASE_CMD_MS 1
+
+static u32 snor_erase_cost(const struct snor_erase_type *et)
+{
+	if (et->typ_ms)
+		return et->typ_ms + SNOR_ERASE_CMD_MS;
+	if (et->size <= 0x1000)
+		return 45 + SNOR_ERASE_CMD_MS;
+	if (et->size <= 0x8000)
+		return 120 + SNOR_ERASE_CMD_MS;
+	return 150 * (et->size / 0x10000) + SNOR_ERASE_CMD_MS;
+}
+
+struct snor_erase_plan {
+	unsigned long offs;
+	unsigned long len;
+	u32 grain;          /* smallest erase size, the plan's step */
+	unsigned long n;    /* steps in the range */
+	u8 *choice;         /* best erase type to start at each step */
+	unsigned long cost; /* estimated ms */
+	bool chip;          /* one chip erase instead */
+};
+
+/* Cheapest exact cover of [offs, offs + len): cost[i] is the best cost from
+ * step i to the end, and each step may start any erase type it is aligned
+ * to and that fits */
+static int snor_erase_plan_build(struct snor_erase_plan *plan, unsigned long offs, unsigned long len)
+{
+	unsigned long *cost, i;
+	int t;
+
+	memset(plan, 0, sizeof(*plan));
+	plan->offs = offs;
+	plan->len = len;
+	plan->grain = snor_caps.n_erase ? snor_caps.erase[0].size : spi_chip_info->sector_size;
+	if ((offs | len) % plan->grain) {
+		printf("Erase range 0x%08lx+0x%lx is not aligned to the 0x%x erase size\n",
+			offs, len, plan->grain);
+		return -1;
+	}
+	plan->n = len / plan->grain;
+	cost = malloc((plan->n + 1) * sizeof(*cost));
+	plan->choice = malloc(plan->n + 1);
+	if (!cost || !plan->choice) {
+		free(cost);
+		free(plan->choice);
+		plan->choice = NULL;
+		return -1;
+	}
+
+	cost[plan->n] = 0;
+	for (i = plan->n; i-- > 0;) {
+		unsigned long addr = offs + i * plan->grain;
+		cost[i] = (unsigned long)-1;
+		plan->choice[i] = 0xff;
+		for (t = 0; t < snor_caps.n_erase; t++) {
+			const struct snor_erase_type *et = &snor_caps.erase[t];
+			unsigned long steps = et->size / plan->grain;
+			if (addr % et->size || i + steps > plan->n || cost[i + steps] == (unsigned long)-1)
+				continue;
+			if (snor_erase_cost(et) + cost[i + steps] < cost[i]) {
+				cost[i] = snor_erase_cost(et) + cost[i + steps];
+				plan->choice[i] = t;
+			}
+		}
+	}
+	plan->cost = cost[0];
+	free(cost);
+	if (plan->cost == (unsigned long)-1) {
+		printf("Erase range 0x%08lx+0x%lx cannot be covered by the chip's erase sizes\n", offs, len);
+		free(plan->choice);
+		plan->choice = NULL;
+		return -1;
+	}
+
+	/* A chip erase wins ties: one command, and no estimate to trust */
+	if (!offs && len == spi_chip_info->sector_size * spi_chip_info->n_sectors) {
+		unsigned long chip_ms = snor_caps.chip_typ_ms;
+		if (!chip_ms) {
+			struct snor_erase_type et = snor_sector_erase();
+			chip_ms = (snor_erase_cost(&et) - SNOR_ERASE_CMD_MS) * spi_chip_info->n_sectors;
+		}
+		plan->chip = chip_ms + SNOR_ERASE_CMD_MS <= plan->cost;
+	}
+	return 0;
+}
+
+static void snor_erase_plan_print(const struct snor_erase_plan *plan)
+{
+	unsigned long counts[SNOR_ERASE_TYPES] = { 0 }, i;
+	int t;
+
+	if (!debug_enabled)
+		return;
+	for (i = 0; i < plan->n; i += snor_caps.erase[plan->choice[i]].size / plan->grain)
+		counts[plan->choice[i]]++;
+	fprintf(stderr, "[DEBUG] snor_erase: 0x%08lx+0x%lx, est %lu ms:", plan->offs, plan->len, plan->cost);
+	for (t = 0; t < snor_caps.n_erase; t++)
+		if (counts[t])
+			fprintf(stderr, " %lu x %uK (0x%02x)", counts[t], snor_caps.erase[t].size >> 10,
+				snor_caps.erase[t].opcode);
+	fprintf(stderr, "%s\n", plan->chip ? ", chip erase instead" : "");
+	/* The plan itself, one line per run of the same erase type */
+	for (i = 0; i < plan->n;) {
+		const struct snor_erase_type *et = &snor_caps.erase[plan->choice[i]];
+		unsigned long start = i, k = 0;
+		while (i < plan->n && &snor_caps.erase[plan->choice[i]] == et) {
+			i += et->size / plan->grain;
+			k++;
+		}
+		fprintf(stderr, "[DEBUG] snor_erase:   0x%08lx: %lu x %uK\n",
+			plan->offs + start * plan->grain, k, et->size >> 10);
+	}
+}
+
+/* Carry out a plan's block erases; done and total only drive progress */
+static int snor_erase_plan_run(const struct snor_erase_plan *plan, unsigned long done, unsigned long total)
+{
+	unsigned long offs = plan->offs, i;
+
+	snor_addr_mode_begin();
+	for (i = 0; i < plan->n;) {
+		const struct snor_erase_type *et = &snor_caps.erase[plan->choice[i]];
+
+		if (snor_erase_unit(offs, et)) {
+			snor_addr_mode_end();
+			return -1;
+		}
+		i += et->size / plan->grain;
+		offs += et->size;
+		done += et->size;
+		timer_progress("Erase", done, total);
+	}
+	snor_addr_mode_end();
+	return 0;
+}
+
 int snor_erase(unsigned long offs, unsigned long len)
 {
 	unsigned long plen = len;
-	unsigned long full_span = spi_chip_info->sector_size * spi_chip_info->n_sectors;
+	struct snor_erase_plan plan;
 	// snor_dbg("%s: offs:%x len:%x\n", __func__, offs, len); // Commented out missing function
 
 	/* sanity checks */
 	if (len == 0)
 		return -1;
 
-	if (!offs && len == full_span) {
+	/* Programmers with a native erase take the whole range at once */
+	timer_start();
+	switch (SPI_CONTROLLER_Erase_Block(offs, len)) {
+	case SPI_CONTROLLER_RTN_NOT_SUPPORTED:
+		break;
+	case SPI_CONTROLLER_RTN_NO_ERROR:
+		printf("Erase 100%% [%lu] of [%lu] bytes\n", len, len);
+		timer_end();
+		return 0;
+	default:
+		timer_end();
+		return -1;
+	}
+
+	if (snor_erase_plan_build(&plan, offs, len)) {
+		timer_end();
+		return -1;
+	}
+	snor_erase_plan_print(&plan);
+
+	if (plan.chip) {
 		printf("Please Wait......\n");
-		if (full_erase_chip() == 0)
+		if (full_erase_chip() == 0) {
+			free(plan.choice);
+			snor_timing_report();
 			return 0;
+		}
 		printf("[WARN] Bulk erase failed, falling back to sector erase.\n");
 	}
 
@@ -1026,25 +1539,102 @@ int snor_erase(unsigned long offs, unsigned long len)
 
 	snor_unprotect();
 
-	/* now erase those sectors */
-	while (len > 0) {
-		if (snor_erase_sector(offs)) {
-			return -1;
-		}
-
-		offs += spi_chip_info->sector_size;
-		len -= spi_chip_info->sector_size;
-		timer_progress("Erase", plen - len, plen);
+	/* now walk the plan */
+	if (snor_erase_plan_run(&plan, 0, plen)) {
+		free(plan.choice);
+		timer_end();
+		return -1;
 	}
-	printf("\rErase 100%% [%lu] of [%lu] bytes      \n", plen - len, plen);
+	free(plan.choice);
+	printf("\rErase 100%% [%lu] of [%lu] bytes      \n", plen, plen);
 	timer_end();
+	snor_timing_report();
 
 	return 0;
 }
 
+/* Bytes moved per step of a streaming read; progress is reported between
+ * steps, the transport splits each step further as it needs to */
+#define SNOR_READ_WINDOW 0x10000
+
+/* Read a range with whatever the programmer does best: its native read, dual
+ * output windows, or one streamed READ. Progress is reported when asked,
+ * and a failure leaves *done at the bytes read so far. */
+static int snor_read_span(unsigned char *buf, unsigned long from, unsigned long len,
+			  bool progress, unsigned long *done)
+{
+	u32 read_addr, remain_len, chunk;
+	u8 cmd[8];
+	unsigned int n, i;
+	bool dual = snor_caps.dual_opcode != 0;
+	SPI_CONTROLLER_RTN_T ret = SPI_CONTROLLER_RTN_NO_ERROR;
+
+	*done = 0;
+
+	/* Programmers with a native read stream the whole range in one session */
+	switch (SPI_CONTROLLER_Read_Range(from, buf, len)) {
+	case SPI_CONTROLLER_RTN_NOT_SUPPORTED:
+		break;
+	case SPI_CONTROLLER_RTN_NO_ERROR:
+		*done = len;
+		return 0;
+	default:
+		return -1;
+	}
+
+	read_addr = from;
+	remain_len = len;
+
+	snor_addr_mode_begin();
+
+	/* Dual output reads (0x3B, or what SFDP names), where the programmer
+	 * and wiring allow, go a window at a time with a command each */
+	while (dual && remain_len > 0) {
+		chunk = min(remain_len, SNOR_READ_WINDOW);
+		n = snor_fill_cmd(cmd, snor_caps.dual_opcode, read_addr);
+		for (i = 0; i < snor_caps.dual_wait / 8u; i++)
+			cmd[n++] = 0xff; /* dummy clocks */
+		ret = SPI_CONTROLLER_Read_Dual(cmd, n, snor_opcode(OPCODE_FAST_READ), &buf[len - remain_len], chunk);
+		if (ret == SPI_CONTROLLER_RTN_NOT_SUPPORTED) {
+			dual = false;
+			ret = SPI_CONTROLLER_RTN_NO_ERROR;
+			break;
+		}
+		if (ret)
+			break;
+		remain_len -= chunk;
+		read_addr += chunk;
+		if (progress)
+			timer_progress("Read", len - remain_len, len);
+	}
+
+	/* Otherwise a single READ streams the rest of the range under one CS
+	 * assertion, with no per-sector command or addressing overhead */
+	if (!ret && remain_len > 0) {
+		n = snor_fill_cmd(cmd, OPCODE_READ, read_addr);
+		ret = SPI_CONTROLLER_Chip_Select_Low();
+		if (!ret)
+			ret = SPI_CONTROLLER_Write_NByte(cmd, n);
+		while (!ret && remain_len > 0) {
+			chunk = min(remain_len, SNOR_READ_WINDOW);
+			ret = SPI_CONTROLLER_Read_NByte(&buf[len - remain_len], chunk);
+			if (ret)
+				break;
+			remain_len -= chunk;
+			read_addr += chunk;
+			if (progress)
+				timer_progress("Read", len - remain_len, len);
+		}
+		SPI_CONTROLLER_Chip_Select_High();
+	}
+	snor_addr_mode_end();
+	*done = len - remain_len;
+	return ret ? -1 : 0;
+}
+
 int snor_read(unsigned char *buf, unsigned long from, unsigned long len)
 {
-	u32 read_addr, physical_read_addr, remain_len, data_offset;
+	unsigned long done;
 
 	// snor_dbg("%s: from:%x len:%x \n", __func__, from, len); // Commented out missing function
 
@@ -1058,73 +1648,64 @@ int snor_read(unsigned char *buf, unsigned long from, unsigned long len)
 		return -1;
 	}
 
-	read_addr = from;
-	remain_len = len;
-	int failed = 0;
-
-	while(remain_len > 0) {
-
-		physical_read_addr = read_addr;
-		data_offset = (physical_read_addr % (spi_chip_info->sector_size));
-
-		if (spi_chip_info->addr4b)
-			snor_4byte_mode(1);
-
-		SPI_CONTROLLER_Chip_Select_Low();
-
-		/* Set up the write data buffer. */
-		SPI_CONTROLLER_Write_One_Byte(OPCODE_READ);
-
-		if (spi_chip_info->addr4b)
-			SPI_CONTROLLER_Write_One_Byte((physical_read_addr >> 24) & 0xff);
-		SPI_CONTROLLER_Write_One_Byte((physical_read_addr >> 16) & 0xff);
-		SPI_CONTROLLER_Write_One_Byte((physical_read_addr >> 8) & 0xff);
-		SPI_CONTROLLER_Write_One_Byte(physical_read_addr & 0xff);
-
-		if( (data_offset + remain_len) < spi_chip_info->sector_size )
-		{
-			if(SPI_CONTROLLER_Read_NByte(&buf[len - remain_len], remain_len)) {
-				SPI_CONTROLLER_Chip_Select_High();
-				if (spi_chip_info->addr4b)
-					snor_4byte_mode(0);
-				failed = 1;
-				break;
-			}
-			remain_len = 0;
-		} else {
-			if(SPI_CONTROLLER_Read_NByte(&buf[len - remain_len], spi_chip_info->sector_size - data_offset)) {
-				SPI_CONTROLLER_Chip_Select_High();
-				if (spi_chip_info->addr4b)
-					snor_4byte_mode(0);
-				failed = 1;
-				break;
-			}
-			remain_len -= spi_chip_info->sector_size - data_offset;
-			read_addr += spi_chip_info->sector_size - data_offset;
-			timer_progress("Read", len - remain_len, len);
-		}
-
-		SPI_CONTROLLER_Chip_Select_High();
-
-		if (spi_chip_info->addr4b)
-			snor_4byte_mode(0);
-	}
-	if (failed) {
+	if (snor_read_span(buf, from, len, true, &done)) {
 		printf("\nRead failed at address 0x%08lx after [%lu] of [%lu] bytes\n",
-			(unsigned long)read_addr, len - remain_len, len);
+			from + done, done, len);
 		timer_end();
 		return -1;
 	}
 
-	printf("\rRead 100%% [%lu] of [%lu] bytes      \n", len - remain_len, len);
+	printf("\rRead 100%% [%lu] of [%lu] bytes      \n", len, len);
 	timer_end();
 
 	return len;
 }
 
+/* Hand the range to a programmer with native page programming, in
+ * SNOR_NATIVE_CHUNK pieces so progress still moves. Returns -2 when the
+ * programmer has no such hook. */
+#define SNOR_NATIVE_CHUNK 0x10000
+
+static int snor_write_native(const unsigned char *buf, unsigned long to, unsigned long len)
+{
+	unsigned long done = 0;
+
+	while (done < len) {
+		u32 chunk = min(len - done, SNOR_NATIVE_CHUNK);
+		SPI_CONTROLLER_RTN_T ret = SPI_CONTROLLER_Program_Page(to + done, buf + done, chunk);
+		if (ret == SPI_CONTROLLER_RTN_NOT_SUPPORTED && !done)
+			return -2;
+		if (ret)
+			return -1;
+		done += chunk;
+		timer_progress("Written", done, len);
+	}
+	return snor_wait_ready(3) ? -1 : 0;
+}
+
+/* Program up to one page at to: opcode, address and data go out in one CS
+ * cycle, batched with the WREN ahead of it. The caller waits for ready. */
+static int snor_page_program(const unsigned char *data, unsigned long to, u32 size)
+{
+	u8 cmd[5 + FLASH_PAGESIZE];
+	unsigned int n;
+	int rc;
+
+	snor_set_progress("PP", to);
+	SPI_CONTROLLER_Queue_Begin();
+	snor_write_enable();
+	n = snor_fill_cmd(cmd, OPCODE_PP, to);
+	memcpy(&cmd[n], data, size);
+	rc = SPI_CONTROLLER_Transaction(cmd, n + size, NULL, 0);
+	if (SPI_CONTROLLER_Queue_End() || rc)
+		return -1;
+	return 0;
+}
+
 int snor_write(unsigned char *buf, unsigned long to, unsigned long len)
 {
 	u32 page_offset, page_size;
+	u32 page = min(snor_caps.page_size, FLASH_PAGESIZE);
 	int rc = 0, retlen = 0;
 	int err = 0;
 	unsigned long plen = len;
@@ -1147,41 +1728,31 @@ int snor_write(unsigned char *buf, unsigned long to, unsigned long len)
 			fprintf(stderr, "[DEBUG] snor_write: continuing after SR_EPE before programming\n");
 	}
 
+	rc = snor_write_native(buf, to, len);
+	if (rc != -2) {
+		if (!rc)
+			printf("\rWritten 100%% [%ld] of [%ld] bytes      \n", plen, plen);
+		timer_end();
+		return rc ? rc : (int)plen;
+	}
 
 	/* what page do we start with? */
-	page_offset = to % FLASH_PAGESIZE;
+	page_offset = to % page;
 
-	if (spi_chip_info->addr4b)
-		snor_4byte_mode(1);
+	/* Unprotect once for the whole range, ahead of 4-byte entry since the
+	 * NOR-MEM unlock resets the chip */
+	if (snor_unprotect()) {
+		timer_end();
+		return -1;
+	}
+	snor_addr_mode_begin();
 
 	/* write everything in PAGESIZE chunks */
 	while (len > 0) {
-		page_size = min(len, FLASH_PAGESIZE - page_offset);
+		page_size = min(len, page - page_offset);
 		page_offset = 0;
 		/* write the next page to flash */
-		if (snor_unprotect()) {
-			err = -1;
-			break;
-		}
-		snor_set_progress("PP", to);
-		snor_write_enable();
-
-		SPI_CONTROLLER_Chip_Select_Low();
-		/* Set up the opcode in the write buffer. */
-		SPI_CONTROLLER_Write_One_Byte(OPCODE_PP);
-
-		if (spi_chip_info->addr4b)
-			SPI_CONTROLLER_Write_One_Byte((to >> 24) & 0xff);
-		SPI_CONTROLLER_Write_One_Byte((to >> 16) & 0xff);
-		SPI_CONTROLLER_Write_One_Byte((to >> 8) & 0xff);
-		SPI_CONTROLLER_Write_One_Byte(to & 0xff);
-
-		if(!SPI_CONTROLLER_Write_NByte(buf, page_size))
-			rc = page_size;
-		else
-			rc = 1;
-
-		SPI_CONTROLLER_Chip_Select_High();
+		rc = snor_page_program(buf, to, page_size) ? 1 : (int)page_size;
 
 		// snor_dbg("%s: to:%x page_size:%x ret:%x\n", __func__, to, page_size, rc); // Commented out missing function
 
@@ -1192,12 +1763,13 @@ int snor_write(unsigned char *buf, unsigned long to, unsigned long len)
 			if (rc < (int)page_size) {
 				printf("%s: rc:%x page_size:%x\n",
 						__func__, rc, page_size);
+				snor_addr_mode_end();
 				snor_write_disable();
 				return retlen - rc;
 			}
 		}
 
-		if (snor_wait_ready(3)) {
+		if (snor_wait_op(SNOR_OP_PP, 3)) {
 			err = -1;
 			break;
 		}
@@ -1212,14 +1784,14 @@ int snor_write(unsigned char *buf, unsigned long to, unsigned long len)
 			err = -1;
 	}
 
-	if (spi_chip_info->addr4b)
-		snor_4byte_mode(0);
+	snor_addr_mode_end();
 
 	snor_write_disable();
 	snor_clear_progress();
 
 	printf("\rWritten 100%% [%ld] of [%ld] bytes      \n", plen - len, plen);
 	timer_end();
+	snor_timing_report();
 
 	if (err) {
 		return err;
@@ -1228,12 +1800,355 @@ int snor_write(unsigned char *buf, unsigned long to, unsigned long len)
 	return retlen;
 }
 
+/* Nonzero when every byte of buf is 0xFF, i.e. erased flash */
+static int snor_blank(const unsigned char *buf, unsigned long len)
+{
+	while (len--)
+		if (*buf++ != 0xff)
+			return 0;
+	return 1;
+}
+
+/* Update state of one erase unit */
+#define SNOR_UNIT_SAME 0     /* already holds the image */
+#define SNOR_UNIT_PROGRAM 1  /* only clears bits: program in place */
+#define SNOR_UNIT_ERASE 2    /* needs some 0->1: erase, then program */
+
+/* Nonzero when new can be programmed over old: no bit goes from 0 to 1 */
+static int snor_clears_only(const unsigned char *old, const unsigned char *new, unsigned long len)
+{
+	while (len--)
+		if (*new++ & ~*old++)
+			return 0;
+	return 1;
+}
+
+/*
+ * Incremental write: read back the erase units the range touches and erase
+ * and program only those that differ from the image. A unit whose change
+ * only clears bits is programmed in place with no erase, page by page where
+ * it differs; an erased unit has the pages holding data programmed. The
+ * verification reads back the changed units alone. Bytes of the edge units
+ * outside the range are kept.
+ */
+int snor_update(unsigned char *buf, unsigned long to, unsigned long len)
+{
+	unsigned long unit = bsize, start, end, span, n, i, j, addr;
+	unsigned long skipped = 0, erased = 0, programmed = 0, in_place = 0, pages = 0, done = 0;
+	unsigned long to_erase = 0;
+	unsigned long chip_size = spi_chip_info->sector_size * spi_chip_info->n_sectors;
+	u32 page = min(snor_caps.page_size, FLASH_PAGESIZE);
+	unsigned char *old = NULL, *img = NULL, *dirty = NULL;
+	unsigned char data[FLASH_PAGESIZE];
+	struct snor_erase_plan plan;
+	int ret = -1;
+
+	/* sanity checks */
+	if (len == 0)
+		return 0;
+	if (len > chip_size || to > chip_size - len)
+		return -1;
+
+	start = to - to % unit;
+	end = to + len + (unit - (to + len) % unit) % unit;
+	span = end - start;
+	n = span / unit;
+
+	old = malloc(span);
+	img = malloc(span);
+	dirty = calloc(n, 1);
+	if (!old || !img || !dirty) {
+		fprintf(stderr, "Malloc failed for update buffers: len=%ld.\n", span);
+		goto out;
+	}
+
+	printf("Reading back 0x%08lx+0x%lx for comparison\n", start, span);
+	if (snor_read(old, start, span) < 0)
+		goto out;
+	memcpy(img, old, span);
+	memcpy(img + (to - start), buf, len);
+
+	for (i = 0; i < n; i++) {
+		if (!memcmp(old + i * unit, img + i * unit, unit)) {
+			dirty[i] = SNOR_UNIT_SAME;
+			skipped++;
+		} else if (snor_clears_only(old + i * unit, img + i * unit, unit)) {
+			dirty[i] = SNOR_UNIT_PROGRAM;
+		} else {
+			dirty[i] = SNOR_UNIT_ERASE;
+			to_erase++;
+		}
+	}
+	if (skipped == n) {
+		ret = len;
+		goto report;
+	}
+
+	/* A programmer that erases the whole chip only can't touch single
+	 * units; a whole-chip update falls back to a full rewrite */
+	if (spi_controller_native_erase()) {
+		if (start || span != chip_size) {
+			printf("Programmer erases the whole chip only, incremental update needs the full chip range\n");
+			goto out;
+		}
+		if (!snor_erase(0, chip_size) && snor_write(img, 0, chip_size) == (int)chip_size) {
+			for (i = 0; i < n; i++)
+				dirty[i] = dirty[i] ? SNOR_UNIT_ERASE : SNOR_UNIT_SAME;
+			erased = programmed = n - skipped;
+			ret = len;
+			goto verify;
+		}
+		goto out;
+	}
+
+	timer_start();
+	if (snor_unprotect()) {
+		timer_end();
+		goto out;
+	}
+
+	/* Erase each run of units that need it through the planner, so aligned
+	 * runs go out as 32K/64K block erases */
+	for (i = 0; i < n; i = j) {
+		for (j = i; j < n && dirty[j] == dirty[i]; j++)
+			;
+		if (dirty[i] != SNOR_UNIT_ERASE)
+			continue;
+		if (snor_erase_plan_build(&plan, start + i * unit, (j - i) * unit)) {
+			timer_end();
+			goto out;
+		}
+		snor_erase_plan_print(&plan);
+		if (snor_erase_plan_run(&plan, done, to_erase * unit)) {
+			free(plan.choice);
+			timer_end();
+			goto out;
+		}
+		free(plan.choice);
+		done += (j - i) * unit;
+		erased += j - i;
+	}
+	if (erased)
+		printf("\rErase 100%% [%lu] of [%lu] bytes      \n", done, done);
+
+	/* Program the pages of erased units that hold data, and the pages of
+	 * in-place units that differ, with 0xFF over bytes already right */
+	snor_addr_mode_begin();
+	for (i = 0, done = 0; i < n; i++) {
+		int wrote = 0;
+
+		if (dirty[i] == SNOR_UNIT_SAME)
+			continue;
+		for (addr = i * unit; addr < (i + 1) * unit; addr += page) {
+			if (dirty[i] == SNOR_UNIT_ERASE) {
+				if (snor_blank(img + addr, page))
+					continue;
+				memcpy(data, img + addr, page);
+			} else {
+				if (!memcmp(old + addr, img + addr, page))
+					continue;
+				for (j = 0; j < page; j++)
+					data[j] = old[addr + j] == img[addr + j] ? 0xff : img[addr + j];
+			}
+			if (snor_page_program(data, start + addr, page) || snor_wait_op(SNOR_OP_PP, 3)) {
+				printf("\nProgram failed at address 0x%08lx\n", start + addr);
+				snor_addr_mode_end();
+				snor_write_disable();
+				snor_clear_progress();
+				timer_end();
+				goto out;
+			}
+			pages++;
+			wrote = 1;
+		}
+		programmed += wrote;
+		in_place += dirty[i] == SNOR_UNIT_PROGRAM;
+		done += unit;
+		timer_progress("Written", done, (n - skipped) * unit);
+	}
+	snor_addr_mode_end();
+	snor_write_disable();
+	snor_clear_progress();
+	printf("\rWritten 100%% [%lu] of [%lu] bytes      \n", pages * page, pages * page);
+	timer_end();
+	ret = len;
+
+verify:
+	/* Read back only the changed units */
+	printf("Verifying changed sectors\n");
+	for (i = 0; i < n; i = j) {
+		for (j = i; j < n && dirty[j] == dirty[i]; j++)
+			;
+		if (!dirty[i])
+			continue;
+		if (snor_read(old + i * unit, start + i * unit, (j - i) * unit) < 0 ||
+		    memcmp(old + i * unit, img + i * unit, (j - i) * unit)) {
+			printf("Verify failed in 0x%08lx+0x%lx\n", start + i * unit, (j - i) * unit);
+			ret = -1;
+			goto report;
+		}
+	}
+
+report:
+	printf("Update: %lu of %lu %luK sectors unchanged and skipped, %lu erased, %lu programmed "
+	       "(%lu of them in place without erase, %lu pages)\n",
+	       skipped, n, unit >> 10, erased, programmed, in_place, pages);
+	snor_timing_report();
+out:
+	free(old);
+	free(img);
+	free(dirty);
+	return ret;
+}
+
+/*
+ * Fused program and verify for an erased range: each erase unit is read back
+ * right after it is programmed, while its source is still hot. With retry
+ * set (-W, whose range was just erased) a unit that reads back wrong is
+ * erased and programmed again up to SNOR_VERIFY_RETRIES times before the job
+ * stops; without it (-w -v) the first bad unit stops the job untouched.
+ * Only one unit is buffered.
+ */
+#define SNOR_VERIFY_RETRIES 2
+
+/* Program an erased span, skipping pages that would stay 0xFF. Native page
+ * programming is used where the programmer has it. */
+static int snor_program_span(const unsigned char *buf, unsigned long to, unsigned long len)
+{
+	u32 page = min(snor_caps.page_size, FLASH_PAGESIZE);
+	unsigned long off, n;
+
+	switch (SPI_CONTROLLER_Program_Page(to, buf, len)) {
+	case SPI_CONTROLLER_RTN_NOT_SUPPORTED:
+		break;
+	case SPI_CONTROLLER_RTN_NO_ERROR:
+		return snor_wait_ready(3) ? -1 : 0;
+	default:
+		return -1;
+	}
+
+	for (off = 0; off < len; off += n) {
+		n = min(len - off, page - (to + off) % page);
+		if (snor_blank(buf + off, n))
+			continue;
+		if (snor_page_program(buf + off, to + off, n) || snor_wait_op(SNOR_OP_PP, 3)) {
+			printf("\nProgram failed at address 0x%08lx\n", to + off);
+			return -1;
+		}
+	}
+	return 0;
+}
+
+int snor_write_verify(unsigned char *buf, unsigned long to, unsigned long len, int retry)
+{
+	unsigned long unit = bsize, end = to + len, pos, next, n, done;
+	unsigned long units = 0, retried = 0, page, bad;
+	struct snor_erase_type et;
+	unsigned char *rb;
+	int attempt, ret = -1;
+	/* Whole-chip-only programmers do their own programming and addressing */
+	bool raw = !spi_controller_native_erase();
+
+	/* sanity checks */
+	if (len == 0)
+		return 0;
+	if (len > spi_chip_info->sector_size * spi_chip_info->n_sectors ||
+	    to > spi_chip_info->sector_size * spi_chip_info->n_sectors - len)
+		return -1;
+
+	rb = malloc(unit);
+	if (!rb) {
+		fprintf(stderr, "Malloc failed for verify buffer: len=%ld.\n", unit);
+		return -1;
+	}
+	et = snor_caps.n_erase ? snor_caps.erase[0] : snor_sector_erase();
+
+	timer_start();
+	if (snor_wait_ready_retry_epe(2) && !snor_wait_error_was_epe()) {
+		timer_end();
+		goto out;
+	}
+	if (raw && snor_unprotect()) {
+		timer_end();
+		goto out;
+	}
+	if (raw)
+		snor_addr_mode_begin();
+
+	for (pos = to; pos < end; pos = next) {
+		next = min(end, (pos / unit + 1) * unit);
+		n = next - pos;
+		if (snor_program_span(buf + (pos - to), pos, n))
+			goto fail;
+
+		for (attempt = 0;; attempt++) {
+			if (snor_read_span(rb, pos, n, false, &done)) {
+				printf("\nVerify read failed at address 0x%08lx\n", pos + done);
+				goto fail;
+			}
+			if (!memcmp(rb, buf + (pos - to), n))
+				break;
+
+			for (page = 0, bad = 0; page < n; page += FLASH_PAGESIZE)
+				bad += memcmp(rb + page, buf + (pos - to) + page, min(n - page, FLASH_PAGESIZE)) != 0;
+			if (!retry) {
+				printf("\nVerify mismatch in 0x%08lx+0x%lx: %lu bad pages\n", pos, n, bad);
+				goto fail;
+			}
+			printf("\nVerify mismatch in 0x%08lx+0x%lx: %lu bad pages (attempt %d of %d)\n",
+			       pos, n, bad, attempt + 1, SNOR_VERIFY_RETRIES + 1);
+			/* Reprogramming needs a unit erase, which whole-chip-only
+			 * programmers can't do */
+			if (attempt == SNOR_VERIFY_RETRIES || !raw)
+				goto fail;
+
+			/* Erase the unit and program it again, keeping the bytes of
+			 * an edge unit that lie outside the range */
+			if (snor_read_span(rb, pos - pos % unit, unit, false, &done))
+				goto fail;
+			memcpy(rb + pos % unit, buf + (pos - to), n);
+			if (snor_erase_unit(pos - pos % unit, &et) ||
+			    snor_program_span(rb, pos - pos % unit, unit))
+				goto fail;
+			retried += !attempt;
+		}
+		units++;
+		timer_progress("Written", next - to, len);
+	}
+	if (raw) {
+		snor_addr_mode_end();
+		snor_write_disable();
+	}
+	snor_clear_progress();
+	printf("\rWritten 100%% [%lu] of [%lu] bytes      \n", len, len);
+	if (retry)
+		printf("Verified %lu sectors as they were written, %lu needed a retry\n", units, retried);
+	else
+		printf("Verified %lu sectors as they were written\n", units);
+	timer_end();
+	snor_timing_report();
+	ret = len;
+	goto out;
+
+fail:
+	if (raw) {
+		snor_addr_mode_end();
+		snor_write_disable();
+	}
+	snor_clear_progress();
+	printf("Stopped at sector 0x%08lx after %lu verified sectors\n", pos - pos % unit, units);
+	timer_end();
+out:
+	free(rb);
+	return ret;
+}
+
 void support_snor_list(void)
 {
 	int i;
 
 	printf("SPI NOR Flash Support List:\n");
-	for ( i = 0; (unsigned long)i < (sizeof(chips_data)/sizeof(struct chip_info)); i++)
+	for ( i = 0; (size_t)i < get_spi_nor_flash_table_size(); i++)
 	{
 		printf("%03d. %s\n", i + 1, chips_data[i].name);
 	}
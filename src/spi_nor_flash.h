@@ -4,6 +4,7 @@
 #include "types.h"
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 
 #define min(a, b) (((a) < (b)) ? (a) : (b))
 
@@ -35,9 +36,11 @@
 #define OPCODE_DIOR 0xBB      /* Dual IO High-Performance Read */
 #define OPCODE_QIOR 0xEB      /* Quad IO High-Performance Read */
 #define OPCODE_READ_ID 0x90   /* Read Manufacturer and Device ID */
+#define OPCODE_SFDP 0x5A      /* Read SFDP parameter tables */
 
 #define OPCODE_P4E 0x20       /* 4KB Parameter Sector Erase */
 #define OPCODE_P8E 0x40       /* 8KB Parameter Sector Erase */
+#define OPCODE_BE32 0x52      /* 32KB Block Erase */
 #define OPCODE_BE 0x60	      /* Bulk Erase */
 #define OPCODE_BE1 0xC7       /* Bulk Erase */
 #define OPCODE_QPP 0x32       /* Quad Page Programing */
@@ -48,6 +51,15 @@
 #define OPCODE_RSTEN 0x66     /* Reset enable (NOR-MEM) */
 #define OPCODE_RST 0x99       /* Reset (NOR-MEM) */
 
+/* Dedicated 4-byte-address opcodes, independent of the addressing mode */
+#define OPCODE_READ4B 0x13      /* Read data bytes, 4-byte address */
+#define OPCODE_FAST_READ4B 0x0C /* Fast Read, 4-byte address */
+#define OPCODE_DOR4B 0x3C       /* Dual Output Read, 4-byte address */
+#define OPCODE_PP4B 0x12        /* Page program, 4-byte address */
+#define OPCODE_SE4B 0xDC        /* Sector erase, 4-byte address */
+#define OPCODE_P4E4B 0x21       /* 4KB sector erase, 4-byte address */
+#define OPCODE_BE32_4B 0x5C     /* 32KB block erase, 4-byte address */
+
 #define OPCODE_CLSR 0x30
 #define OPCODE_RCR 0x35       /* Read Configuration Register */
 
@@ -68,6 +80,11 @@
 #define SR3_BP3 0x01 /* Extended block protect bit */
 #define SR3_WPS 0x20 /* Write protect selection */
 
+/* chip_info.addr4b: how addresses above 16 MB are reached */
+#define SNOR_ADDR3B 0         /* 3-byte addresses only */
+#define SNOR_ADDR4B_MODE 1    /* EN4B/EX4B switch around each operation */
+#define SNOR_ADDR4B_OPCODES 2 /* dedicated 4-byte opcodes, no mode switch */
+
 struct chip_info
 {
 	char *name;
@@ -76,9 +93,43 @@ struct chip_info
 	unsigned long sector_size;
 	unsigned int n_sectors;
 	char addr4b;
+	u16 page_max_us;            /* 0 if unknown */
+	u16 erase_max_ms;           /* per sector_size unit, 0 if unknown */
+};
+
+/* The chip table, in spi_nor_flash_tables.c */
+extern struct chip_info chips_data[];
+size_t get_spi_nor_flash_table_size(void);
+
+/* Capabilities of the detected chip, from its SFDP tables where it has
+ * them and otherwise from the chip table entry. Times of 0 are unknown. */
+#define SNOR_ERASE_TYPES 4
+
+struct snor_erase_type
+{
+	u32 size;        /* bytes */
+	u8 opcode;
+	u32 typ_ms;
+	u32 max_ms;
+};
+
+struct snor_caps
+{
+	bool sfdp;                 /* filled from the SFDP basic parameter table */
+	unsigned long size;        /* bytes */
+	u32 page_size;
+	int n_erase;               /* erase types below, ascending by size */
+	struct snor_erase_type erase[SNOR_ERASE_TYPES];
+	u8 dual_opcode;            /* 1-1-2 fast read, 0 if unusable */
+	u8 dual_wait;              /* dummy plus mode clocks ahead of dual data */
+	u32 page_typ_us;
+	u32 page_max_us;
+	u32 chip_typ_ms;
+	u32 chip_max_ms;
 };
 
 extern struct chip_info *spi_chip_info;
+extern struct snor_caps snor_caps;
 extern unsigned int bsize;
 
 int snor_wait_ready(int sleep_ms);